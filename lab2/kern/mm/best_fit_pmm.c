@@ -107,6 +107,7 @@ best_fit_init_memmap(struct Page *base, size_t n)
             {
                 // 如果到达链表结尾，将base插入到链表尾部
                 list_add(le, &(base->page_link));
+                break;
             }
         }
     }
@@ -201,6 +202,7 @@ best_fit_free_pages(struct Page *base, size_t n)
             else if (list_next(le) == &free_list)
             {
                 list_add(le, &(base->page_link));
+                break;
             }
         }
     }
@@ -92,12 +92,9 @@ static struct Page *slub_object_to_page(void *obj) {
     return kva2page((void *)page_addr);
 }
 
-// 初始化SLUB分配器
+// 初始化SLUB分配器：作为 pmm_manager->init 每次都重新初始化，
+// slub_alloc 和 slub_check 只在尚未初始化时调用它
 static void slub_init(void) {
-    if (slub_allocator.initialized) {
-        return;
-    }
-    
     list_init(&slub_free_list);
     slub_nr_free = 0;
     
@@ -149,6 +146,7 @@ static void slub_init_memmap(struct Page *base, size_t n) {
                     break;
                 } else if (list_next(le) == &slub_free_list) {
                     list_add(le, &(p->page_link));
+                    break;
                 }
             }
         }
@@ -0,0 +1,121 @@
+#include <defs.h>
+#include <riscv.h>
+#include <stdio.h>
+#include <string.h>
+#include <dtb.h>
+#include <boot.h>
+
+static uint32_t boot_checks = BOOT_CHECK_ALL;
+
+static struct
+{
+    const char *name;
+    uint64_t start;         // rdtime when the phase began
+} boot_phases[BOOT_MAX_PHASES];
+static int nr_boot_phases = 0;
+
+static const struct
+{
+    const char *name;
+    uint32_t suite;
+} boot_check_names[] = {
+    {"pmm", BOOT_CHECK_PMM},
+    {"pgdir", BOOT_CHECK_PGDIR},
+    {"vmm", BOOT_CHECK_VMM},
+    {"all", BOOT_CHECK_ALL},
+    {"none", 0},
+};
+
+// boot_parse_checks - turn a comma list of suite names into BOOT_CHECK_* bits
+static uint32_t
+boot_parse_checks(char *list)
+{
+    uint32_t checks = 0;
+    char *p = list;
+    while (*p != '\0')
+    {
+        char *name = p;
+        int i;
+        while (*p != '\0' && *p != ',')
+        {
+            p++;
+        }
+        if (*p == ',')
+        {
+            *p++ = '\0';
+        }
+        for (i = 0; i < sizeof(boot_check_names) / sizeof(boot_check_names[0]); i++)
+        {
+            if (strcmp(name, boot_check_names[i].name) == 0)
+            {
+                checks |= boot_check_names[i].suite;
+                break;
+            }
+        }
+        if (i == sizeof(boot_check_names) / sizeof(boot_check_names[0]))
+        {
+            cprintf("boot: unknown check suite '%s' ignored.\n", name);
+        }
+    }
+    return checks;
+}
+
+// boot_options_init - read the options from the bootargs; dtb_init must have run
+void boot_options_init(void)
+{
+    char buf[64];
+    const char *val;
+    if (dtb_bootarg("fastboot", buf, sizeof(buf)) != NULL)
+    {
+        boot_checks = 0;
+    }
+    if ((val = dtb_bootarg("checks", buf, sizeof(buf))) != NULL && val == buf)
+    {
+        boot_checks = boot_parse_checks(buf);
+    }
+    if (boot_checks != BOOT_CHECK_ALL)
+    {
+        cprintf("boot: self-checks 0x%x of 0x%x enabled.\n", boot_checks, BOOT_CHECK_ALL);
+    }
+}
+
+// boot_check - should the self-check suite @suite run on this boot?
+bool boot_check(uint32_t suite)
+{
+    return (boot_checks & suite) != 0;
+}
+
+// boot_phase - the previous phase, if any, ends here and phase @name begins
+void boot_phase(const char *name)
+{
+    if (nr_boot_phases < BOOT_MAX_PHASES)
+    {
+        boot_phases[nr_boot_phases].name = name;
+        boot_phases[nr_boot_phases].start = rdtime();
+        nr_boot_phases++;
+    }
+}
+
+/* *
+ * boot_summary - end the last phase and print the time spent in each one.
+ * The time CSR starts at reset, so the first phase's start is the time
+ * the firmware took to get to the kernel.
+ * */
+void boot_summary(void)
+{
+    uint64_t freq = get_timebase_freq(), now = rdtime();
+    int i;
+    if (nr_boot_phases == 0 || freq == 0)
+    {
+        return;
+    }
+    uint64_t per_us = (freq >= 1000000) ? freq / 1000000 : 1;
+    cprintf("boot: kernel entered %lu us after reset\n", boot_phases[0].start / per_us);
+    for (i = 0; i < nr_boot_phases; i++)
+    {
+        uint64_t end = (i + 1 < nr_boot_phases) ? boot_phases[i + 1].start : now;
+        cprintf("boot:   %-10s %8lu us\n", boot_phases[i].name, (end - boot_phases[i].start) / per_us);
+    }
+    cprintf("boot: first user process after %lu us in the kernel\n", (now - boot_phases[0].start) / per_us);
+    nr_boot_phases = 0;
+}
@@ -0,0 +1,28 @@
+#ifndef __KERN_DEBUG_BOOT_H__
+#define __KERN_DEBUG_BOOT_H__
+
+#include <defs.h>
+
+/* *
+ * Boot phases and options. kern_init marks the start of each init stage
+ * with boot_phase(); init_main prints how long every stage took with
+ * boot_summary() just before it starts the first user process.
+ *
+ * The self-check suites run by default. The DTB bootargs (make qemu
+ * BOOTARGS=...) select them: "checks=none", "checks=all" or a comma list
+ * such as "checks=pmm,vmm"; "fastboot" is short for "checks=none".
+ * */
+
+#define BOOT_CHECK_PMM      0x1     // the pmm_manager->check() allocation sweeps
+#define BOOT_CHECK_PGDIR    0x2     // check_pgdir, check_boot_pgdir
+#define BOOT_CHECK_VMM      0x4     // check_vmm
+#define BOOT_CHECK_ALL      (BOOT_CHECK_PMM | BOOT_CHECK_PGDIR | BOOT_CHECK_VMM)
+
+#define BOOT_MAX_PHASES     16
+
+void boot_options_init(void);
+bool boot_check(uint32_t suite);
+void boot_phase(const char *name);
+void boot_summary(void);
+
+#endif /* !__KERN_DEBUG_BOOT_H__ */
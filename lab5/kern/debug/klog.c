@@ -0,0 +1,215 @@
+#include <defs.h>
+#include <atomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <clock.h>
+#include <console.h>
+#include <smp.h>
+#include <spinlock.h>
+#include <proc.h>
+#include <trap.h>
+#include <workqueue.h>
+#include <klog.h>
+
+#define KLOG_MASK (KLOG_NR_RECORDS - 1)
+
+/* *
+ * A record is published by storing seq + 1 into its seq field after the
+ * text; 0 means the slot is being (re)written. Readers copy the record and
+ * check that seq did not change meanwhile, like a seqlock.
+ * */
+struct klog_record
+{
+    volatile uint32_t seq;
+    uint8_t level;
+    uint8_t cpu;
+    uint16_t len;
+    uint32_t ticks;
+    char text[KLOG_LINE_MAX];
+};
+
+static struct klog_record klog_ring[KLOG_NR_RECORDS];
+static atomic_t klog_head = ATOMIC_INIT(0);     // the next sequence number to hand out
+
+int klog_console_level = KLOG_INFO;
+
+// the console drain: one hart at a time copies records from klog_con_seq on
+static spinlock_t klog_drain_lock = SPINLOCK_INIT("klog_drain");
+static uint32_t klog_con_seq = 0;
+static size_t klog_con_lost = 0;                // overwritten before they reached the console
+
+static struct work_struct klog_work;
+
+static const char *klog_level_names[] = {"err", "warn", "info", "debug"};
+
+static void
+klog_work_func(struct work_struct *work)
+{
+    klog_flush();
+}
+
+void klog_init(void)
+{
+    INIT_WORK(&klog_work, klog_work_func);
+}
+
+/* *
+ * klog_ratelimit - may the call site owning @rs log once more in this
+ * window? The counters are updated without a lock; a race only lets a
+ * message more or less through.
+ * */
+bool klog_ratelimit(struct klog_ratelimit *rs)
+{
+    size_t now = ticks;
+    if (rs->printed == 0 || now - rs->begin >= KLOG_INTERVAL)
+    {
+        int missed = rs->missed;
+        rs->begin = now, rs->printed = rs->missed = 0;
+        if (missed != 0)
+        {
+            __klog(KLOG_WARN, "klog: %d messages suppressed\n", missed);
+        }
+    }
+    if (rs->printed >= KLOG_BURST)
+    {
+        rs->missed++;
+        return 0;
+    }
+    rs->printed++;
+    return 1;
+}
+
+/* *
+ * klog_fetch - copy record @seq into @out. Returns 0 on success, 1 if it
+ * has been overwritten by a newer one and -1 if it is not published yet.
+ * */
+static int
+klog_fetch(uint32_t seq, struct klog_record *out)
+{
+    struct klog_record *r = &klog_ring[seq & KLOG_MASK];
+    uint32_t s = r->seq;
+    if (s != seq + 1)
+    {
+        return ((int32_t)(s - (seq + 1)) > 0) ? 1 : -1;
+    }
+    __sync_synchronize();
+    *out = *r;
+    __sync_synchronize();
+    return (r->seq == s) ? 0 : 1;
+}
+
+/* *
+ * klog_wakeup - get a new console record drained. Before the scheduler
+ * runs it is printed right away. Later on it is handed to a system_wq
+ * worker if one is alive; none is started for it, since starting one
+ * forks and klog may be called with spinlocks held. Without a worker, and
+ * from interrupt handlers, the record waits for the next drain or for the
+ * idle loop.
+ * */
+static void
+klog_wakeup(void)
+{
+    if (in_interrupt())
+    {
+        return;
+    }
+    if (system_wq == NULL || current == NULL || current == idleproc)
+    {
+        klog_flush();
+        return;
+    }
+    queue_work_nospawn(system_wq, &klog_work);
+}
+
+// __klog - the body of klog(): format into the next slot of the ring
+void __klog(int level, const char *fmt, ...)
+{
+    uint32_t seq = (uint32_t)atomic_fetch_add(&klog_head, 1);
+    struct klog_record *r = &klog_ring[seq & KLOG_MASK];
+    va_list ap;
+
+    r->seq = 0;
+    __sync_synchronize();
+    r->level = level;
+    r->cpu = mycpu()->id;
+    r->ticks = ticks;
+    va_start(ap, fmt);
+    int len = vsnprintf(r->text, sizeof(r->text), fmt, ap);
+    va_end(ap);
+    r->len = (len < (int)sizeof(r->text)) ? len : sizeof(r->text) - 1;
+    __sync_synchronize();
+    r->seq = seq + 1;
+
+    if (level <= klog_console_level)
+    {
+        klog_wakeup();
+    }
+}
+
+/* *
+ * klog_flush - copy the records that are due to the console. Another hart
+ * already draining finishes the job; a panic that interrupted the drain
+ * on this hart goes on from where it stopped.
+ * */
+void klog_flush(void)
+{
+    struct klog_record rec;
+    bool locked = spin_trylock(&klog_drain_lock);
+    if (!locked && !spin_holding(&klog_drain_lock))
+    {
+        return;
+    }
+    uint32_t head = (uint32_t)atomic_read(&klog_head);
+    if (head - klog_con_seq > KLOG_NR_RECORDS)
+    {
+        klog_con_lost += head - klog_con_seq - KLOG_NR_RECORDS;
+        klog_con_seq = head - KLOG_NR_RECORDS;
+    }
+    while (klog_con_seq != head)
+    {
+        int ret = klog_fetch(klog_con_seq, &rec);
+        if (ret < 0)
+        {
+            // still being written, its writer will call us again
+            break;
+        }
+        klog_con_seq++;
+        if (ret > 0)
+        {
+            klog_con_lost++;
+        }
+        else if (rec.level <= klog_console_level)
+        {
+            cons_write(rec.text, rec.len);
+        }
+    }
+    if (locked)
+    {
+        spin_unlock(&klog_drain_lock);
+    }
+}
+
+// klog_dump - print the last @nr records of the ring (all of them if @nr <= 0)
+void klog_dump(int nr)
+{
+    struct klog_record rec;
+    uint32_t head = (uint32_t)atomic_read(&klog_head);
+    uint32_t seq = (head > KLOG_NR_RECORDS) ? head - KLOG_NR_RECORDS : 0;
+    if (nr > 0 && head - seq > (uint32_t)nr)
+    {
+        seq = head - nr;
+    }
+    for (; seq != head; seq++)
+    {
+        if (klog_fetch(seq, &rec) != 0)
+        {
+            continue;
+        }
+        cprintf("[%6d] cpu%d %-5s %.*s", rec.ticks, rec.cpu, klog_level_names[rec.level], rec.len, rec.text);
+        if (rec.len == 0 || rec.text[rec.len - 1] != '\n')
+        {
+            cprintf("\n");
+        }
+    }
+    cprintf("%u messages logged, %lu lost before reaching the console.\n", head, klog_con_lost);
+}
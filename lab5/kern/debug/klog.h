@@ -0,0 +1,68 @@
+#ifndef __KERN_DEBUG_KLOG_H__
+#define __KERN_DEBUG_KLOG_H__
+
+#include <defs.h>
+
+/* *
+ * Kernel log. klog(level, fmt, ...) formats the message into a slot of an
+ * in-memory ring and returns; nothing is printed on the caller's path.
+ * Messages at or below klog_console_level are copied to the console later,
+ * by a work item on system_wq, by the idle loop, or right away while the
+ * scheduler is not running yet. The kernel monitor shows the whole ring
+ * with `dmesg'.
+ *
+ * Writers reserve a slot with one amoadd and never take a lock or start a
+ * thread, so klog may be used from interrupt handlers and with spinlocks
+ * held. Each call site is rate limited to KLOG_BURST messages per
+ * KLOG_INTERVAL ticks. Call sites above KLOG_LEVEL (make
+ * DEFS+=-DKLOG_LEVEL=3 for everything) are compiled out, format string and
+ * arguments included.
+ * */
+
+#define KLOG_ERR    0
+#define KLOG_WARN   1
+#define KLOG_INFO   2
+#define KLOG_DEBUG  3
+
+#ifndef KLOG_LEVEL
+#define KLOG_LEVEL  KLOG_INFO
+#endif
+
+#define KLOG_NR_RECORDS 256             // ring size, a power of two
+#define KLOG_LINE_MAX   120             // longest message kept, with its '\0'
+
+#define KLOG_INTERVAL   100             // rate limit window, in ticks
+#define KLOG_BURST      10              // messages per call site and window
+
+struct klog_ratelimit
+{
+    size_t begin;                       // tick the current window started at
+    int printed;                        // messages let through in this window
+    int missed;                         // messages dropped in this window
+};
+
+#define KLOG_RATELIMIT_INIT {.begin = 0, .printed = 0, .missed = 0}
+
+extern int klog_console_level;
+
+void klog_init(void);
+bool klog_ratelimit(struct klog_ratelimit *rs);
+void __klog(int level, const char *fmt, ...);
+void klog_flush(void);
+void klog_dump(int nr);
+
+#define klog(level, fmt, ...)                                      \
+    do                                                             \
+    {                                                              \
+        if ((level) <= KLOG_LEVEL)                                 \
+        {                                                          \
+            static struct klog_ratelimit __klog_rs =               \
+                KLOG_RATELIMIT_INIT;                               \
+            if (klog_ratelimit(&__klog_rs))                        \
+            {                                                      \
+                __klog((level), fmt, ##__VA_ARGS__);               \
+            }                                                      \
+        }                                                          \
+    } while (0)
+
+#endif /* !__KERN_DEBUG_KLOG_H__ */
@@ -4,6 +4,13 @@
 #include <trap.h>
 #include <kmonitor.h>
 #include <kdebug.h>
+#include <picirq.h>
+#include <sched.h>
+#include <spinlock.h>
+#include <vmm.h>
+#include <klog.h>
+#include <profile.h>
+#include <trace.h>
 
 /* *
  * Simple command-line kernel monitor useful for controlling the
@@ -22,6 +29,12 @@ static struct command commands[] = {
     {"help", "Display this list of commands.", mon_help},
     {"kerninfo", "Display information about the kernel.", mon_kerninfo},
     {"backtrace", "Print backtrace of stack frame.", mon_backtrace},
+    {"interrupts", "Display per-IRQ external interrupt counts.", mon_interrupts},
+    {"schedstat", "Display kernel preemption statistics.", mon_schedstat},
+    {"lockstat", "Display lock contention statistics.", mon_lockstat},
+    {"dmesg", "Display the kernel log, or its last N records.", mon_dmesg},
+    {"profile", "Display the hottest sampled pcs: profile [N | reset | rate N].", mon_profile},
+    {"trace", "Dump or control the event trace: trace [raw | clear | on [MASK] | off].", mon_trace},
 };
 
 /* return if kernel is panic, in kern/debug/panic.c */
@@ -145,3 +158,99 @@ int mon_backtrace(int argc, char **argv, struct trapframe *tf)
     print_stackframe();
     return 0;
 }
+
+/* *
+ * mon_interrupts - call print_irq_stats in kern/driver/picirq.c to
+ * print how often each external interrupt source has fired.
+ * */
+int mon_interrupts(int argc, char **argv, struct trapframe *tf)
+{
+    print_irq_stats();
+    return 0;
+}
+
+/* *
+ * mon_schedstat - call print_sched_stats in kern/schedule/sched.c to
+ * print how often the kernel was preempted and the worst delay.
+ * */
+int mon_schedstat(int argc, char **argv, struct trapframe *tf)
+{
+    print_sched_stats();
+    return 0;
+}
+
+/* *
+ * mon_lockstat - call lock_stat_print in kern/sync/spinlock.c to print
+ * the contention counters of the spinlocks (LOCK_STAT builds only), and
+ * print_mm_lock_stats in kern/mm/vmm.c for those of the semaphores of
+ * the mms destroyed so far.
+ * */
+int mon_lockstat(int argc, char **argv, struct trapframe *tf)
+{
+    lock_stat_print();
+    print_mm_lock_stats();
+    return 0;
+}
+
+/* *
+ * mon_dmesg - call klog_dump in kern/debug/klog.c to print the kernel log
+ * ring, all of it or the last argv[0] records.
+ * */
+int mon_dmesg(int argc, char **argv, struct trapframe *tf)
+{
+    klog_dump((argc > 0) ? (int)strtol(argv[0], NULL, 0) : 0);
+    return 0;
+}
+
+/* *
+ * mon_profile - call profile_report in kern/debug/profile.c to print the
+ * hottest pcs (20, or argv[0] of them); `profile reset' drops the samples
+ * and `profile rate N' samples every N-th tick, 0 turns sampling off.
+ * */
+int mon_profile(int argc, char **argv, struct trapframe *tf)
+{
+    if (argc > 0 && strcmp(argv[0], "reset") == 0)
+    {
+        profile_reset();
+    }
+    else if (argc > 1 && strcmp(argv[0], "rate") == 0)
+    {
+        prof_interval = (int)strtol(argv[1], NULL, 0);
+    }
+    else
+    {
+        profile_report((argc > 0) ? (int)strtol(argv[0], NULL, 0) : 20);
+    }
+    return 0;
+}
+
+/* *
+ * mon_trace - call trace_dump in kern/debug/trace.c to print the event
+ * trace, as text or (`trace raw') as hex records for the host; `trace
+ * on [MASK]' enables the events in MASK (all by default), `trace off'
+ * disables them and `trace clear' drops the records.
+ * */
+int mon_trace(int argc, char **argv, struct trapframe *tf)
+{
+    if (argc == 0 || strcmp(argv[0], "raw") == 0)
+    {
+        trace_dump(argc != 0);
+    }
+    else if (strcmp(argv[0], "clear") == 0)
+    {
+        trace_clear();
+    }
+    else if (strcmp(argv[0], "on") == 0)
+    {
+        trace_mask = (argc > 1) ? (uint32_t)strtol(argv[1], NULL, 0) & TRACE_ALL : TRACE_ALL;
+    }
+    else if (strcmp(argv[0], "off") == 0)
+    {
+        trace_mask = 0;
+    }
+    else
+    {
+        cprintf("Unknown trace command '%s'\n", argv[0]);
+    }
+    return 0;
+}
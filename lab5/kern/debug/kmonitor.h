@@ -8,6 +8,12 @@ void kmonitor(struct trapframe *tf);
 int mon_help(int argc, char **argv, struct trapframe *tf);
 int mon_kerninfo(int argc, char **argv, struct trapframe *tf);
 int mon_backtrace(int argc, char **argv, struct trapframe *tf);
+int mon_interrupts(int argc, char **argv, struct trapframe *tf);
+int mon_schedstat(int argc, char **argv, struct trapframe *tf);
+int mon_lockstat(int argc, char **argv, struct trapframe *tf);
+int mon_dmesg(int argc, char **argv, struct trapframe *tf);
+int mon_profile(int argc, char **argv, struct trapframe *tf);
+int mon_trace(int argc, char **argv, struct trapframe *tf);
 int mon_continue(int argc, char **argv, struct trapframe *tf);
 int mon_step(int argc, char **argv, struct trapframe *tf);
 int mon_breakpoint(int argc, char **argv, struct trapframe *tf);
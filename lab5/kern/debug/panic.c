@@ -3,6 +3,8 @@
 #include <intr.h>
 #include <kmonitor.h>
 #include <sbi.h>
+#include <console.h>
+#include <klog.h>
 
 static bool is_panic = 0;
 
@@ -17,6 +19,7 @@ void __panic(const char *file, int line, const char *fmt, ...)
         goto panic_dead;
     }
     is_panic = 1;
+    klog_flush();
 
     // print the 'message'
     va_list ap;
@@ -28,6 +31,7 @@ void __panic(const char *file, int line, const char *fmt, ...)
 
 panic_dead:
     // No debug monitor here
+    cons_flush();
     sbi_shutdown();
     intr_disable();
     while (1)
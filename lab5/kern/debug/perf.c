@@ -0,0 +1,285 @@
+#include <defs.h>
+#include <riscv.h>
+#include <sbi.h>
+#include <stdio.h>
+#include <string.h>
+#include <error.h>
+#include <sync.h>
+#include <smp.h>
+#include <proc.h>
+#include <vmm.h>
+#include <kmalloc.h>
+#include <perf.h>
+
+// one hart's counter for one event
+struct perf_counter
+{
+    int idx;                // SBI counter index, -1 if the event is not available
+    int csr;                // the hpmcounter to read it from, unless fw
+    bool fw;                // a firmware counter, read through SBI
+    uint64_t mask;          // counter width
+};
+
+static struct perf_counter perf_counters[NCPU][PERF_NR_EVENTS];
+static bool pmu_present = 0;
+static int nr_pmu_counters = 0;
+
+static const unsigned long perf_sbi_events[PERF_NR_EVENTS] = {
+    [PERF_CYCLES] = SBI_PMU_EVENT_HW(SBI_PMU_HW_CPU_CYCLES),
+    [PERF_INSTRUCTIONS] = SBI_PMU_EVENT_HW(SBI_PMU_HW_INSTRUCTIONS),
+    [PERF_CACHE_REFS] = SBI_PMU_EVENT_HW(SBI_PMU_HW_CACHE_REFERENCES),
+    [PERF_CACHE_MISSES] = SBI_PMU_EVENT_HW(SBI_PMU_HW_CACHE_MISSES),
+    [PERF_BRANCH_MISSES] = SBI_PMU_EVENT_HW(SBI_PMU_HW_BRANCH_MISSES),
+    [PERF_L1D_MISSES] = SBI_PMU_EVENT_CACHE(SBI_PMU_CACHE_L1D, SBI_PMU_CACHE_OP_READ, SBI_PMU_CACHE_RESULT_MISS),
+    [PERF_DTLB_MISSES] = SBI_PMU_EVENT_CACHE(SBI_PMU_CACHE_DTLB, SBI_PMU_CACHE_OP_READ, SBI_PMU_CACHE_RESULT_MISS),
+    [PERF_ITLB_MISSES] = SBI_PMU_EVENT_CACHE(SBI_PMU_CACHE_ITLB, SBI_PMU_CACHE_OP_READ, SBI_PMU_CACHE_RESULT_MISS),
+};
+
+static const char *perf_event_names[PERF_NR_EVENTS] = {
+    [PERF_CYCLES] = "cycles",
+    [PERF_INSTRUCTIONS] = "instructions",
+    [PERF_CACHE_REFS] = "cache-refs",
+    [PERF_CACHE_MISSES] = "cache-misses",
+    [PERF_BRANCH_MISSES] = "branch-misses",
+    [PERF_L1D_MISSES] = "l1d-misses",
+    [PERF_DTLB_MISSES] = "dtlb-misses",
+    [PERF_ITLB_MISSES] = "itlb-misses",
+};
+
+#define PERF_CSR_CASE(csr) \
+    case csr:              \
+        return read_csr(csr)
+
+// perf_read_csr - csrr needs the CSR number in the instruction
+static uint64_t
+perf_read_csr(int csr)
+{
+    switch (csr)
+    {
+        PERF_CSR_CASE(0xc00); PERF_CSR_CASE(0xc01); PERF_CSR_CASE(0xc02); PERF_CSR_CASE(0xc03);
+        PERF_CSR_CASE(0xc04); PERF_CSR_CASE(0xc05); PERF_CSR_CASE(0xc06); PERF_CSR_CASE(0xc07);
+        PERF_CSR_CASE(0xc08); PERF_CSR_CASE(0xc09); PERF_CSR_CASE(0xc0a); PERF_CSR_CASE(0xc0b);
+        PERF_CSR_CASE(0xc0c); PERF_CSR_CASE(0xc0d); PERF_CSR_CASE(0xc0e); PERF_CSR_CASE(0xc0f);
+        PERF_CSR_CASE(0xc10); PERF_CSR_CASE(0xc11); PERF_CSR_CASE(0xc12); PERF_CSR_CASE(0xc13);
+        PERF_CSR_CASE(0xc14); PERF_CSR_CASE(0xc15); PERF_CSR_CASE(0xc16); PERF_CSR_CASE(0xc17);
+        PERF_CSR_CASE(0xc18); PERF_CSR_CASE(0xc19); PERF_CSR_CASE(0xc1a); PERF_CSR_CASE(0xc1b);
+        PERF_CSR_CASE(0xc1c); PERF_CSR_CASE(0xc1d); PERF_CSR_CASE(0xc1e); PERF_CSR_CASE(0xc1f);
+    }
+    return 0;
+}
+
+static inline uint64_t
+perf_counter_value(struct perf_counter *c)
+{
+    if (c->fw)
+    {
+        return sbi_pmu_counter_fw_read(c->idx).value;
+    }
+    return perf_read_csr(c->csr);
+}
+
+/* *
+ * perf_init_hart - claim and start a counter for every event this hart
+ * can count. Counters exclude M-mode, so SBI calls are not charged to the
+ * process that made them.
+ * */
+void perf_init_hart(void)
+{
+    struct perf_counter *counters = perf_counters[mycpu()->id];
+    unsigned long mask = (nr_pmu_counters >= __riscv_xlen) ? ~0UL : (1UL << nr_pmu_counters) - 1;
+    int e;
+    for (e = 0; e < PERF_NR_EVENTS; e++)
+    {
+        struct perf_counter *c = &counters[e];
+        c->idx = -1;
+        if (!pmu_present)
+        {
+            continue;
+        }
+        struct sbiret ret = sbi_pmu_counter_config_matching(0, mask,
+                                                            SBI_PMU_CFG_FLAG_CLEAR_VALUE | SBI_PMU_CFG_FLAG_AUTO_START | SBI_PMU_CFG_FLAG_SET_MINH,
+                                                            perf_sbi_events[e], 0);
+        if (ret.error != SBI_SUCCESS)
+        {
+            continue;
+        }
+        int idx = ret.value;
+        ret = sbi_pmu_counter_get_info(idx);
+        if (ret.error != SBI_SUCCESS ||
+            (!SBI_PMU_INFO_FW(ret.value) && (SBI_PMU_INFO_CSR(ret.value) < CSR_CYCLE || SBI_PMU_INFO_CSR(ret.value) > CSR_CYCLE + 31)))
+        {
+            sbi_pmu_counter_stop(idx, 1, SBI_PMU_STOP_FLAG_RESET);
+            continue;
+        }
+        int width = SBI_PMU_INFO_WIDTH(ret.value);
+        c->idx = idx;
+        c->fw = SBI_PMU_INFO_FW(ret.value);
+        c->csr = SBI_PMU_INFO_CSR(ret.value);
+        c->mask = (width >= 64) ? ~0ULL : (1ULL << width) - 1;
+    }
+}
+
+// perf_init - probe the SBI PMU extension and set up the boot hart's counters
+void perf_init(void)
+{
+    int e;
+    if (sbi_probe_extension(SBI_EXT_PMU))
+    {
+        struct sbiret ret = sbi_pmu_num_counters();
+        if (ret.error == SBI_SUCCESS && ret.value > 0)
+        {
+            pmu_present = 1;
+            nr_pmu_counters = ret.value;
+        }
+    }
+    perf_init_hart();
+    if (!pmu_present)
+    {
+        cprintf("perf: no SBI PMU, counters unavailable.\n");
+        return;
+    }
+    cprintf("perf: %d counters, events:", nr_pmu_counters);
+    for (e = 0; e < PERF_NR_EVENTS; e++)
+    {
+        if (perf_event_supported(e))
+        {
+            cprintf(" %s", perf_event_names[e]);
+        }
+    }
+    cprintf("\n");
+}
+
+// perf_event_supported - can @event be counted? (the harts are assumed alike)
+bool perf_event_supported(int event)
+{
+    return event >= 0 && event < PERF_NR_EVENTS && perf_counters[0][event].idx >= 0;
+}
+
+// perf_counter_read - the free-running counter of @event on this hart, 0 if there is none
+uint64_t perf_counter_read(int event)
+{
+    struct perf_counter *c = &perf_counters[mycpu()->id][event];
+    return (c->idx >= 0) ? perf_counter_value(c) : 0;
+}
+
+// perf_elapsed - what @event counted on this hart since @start
+static inline uint64_t
+perf_elapsed(int event, uint64_t start)
+{
+    struct perf_counter *c = &perf_counters[mycpu()->id][event];
+    if (c->idx < 0)
+    {
+        return 0;
+    }
+    return (perf_counter_value(c) - start) & c->mask;
+}
+
+/* *
+ * perf_switch - called by proc_run with interrupts disabled: charge @prev
+ * for its time slice and note where @next starts from on this hart.
+ * Processes that never opened an event cost two NULL checks.
+ * */
+void perf_switch(struct proc_struct *prev, struct proc_struct *next)
+{
+    struct perf_ctx *ctx;
+    int e;
+    if ((ctx = prev->perf) != NULL)
+    {
+        for (e = 0; e < PERF_NR_EVENTS; e++)
+        {
+            if (ctx->open_mask & (1 << e))
+            {
+                ctx->count[e] += perf_elapsed(e, ctx->start[e]);
+            }
+        }
+    }
+    if ((ctx = next->perf) != NULL)
+    {
+        for (e = 0; e < PERF_NR_EVENTS; e++)
+        {
+            if (ctx->open_mask & (1 << e))
+            {
+                ctx->start[e] = perf_counter_read(e);
+            }
+        }
+    }
+}
+
+// perf_release - drop the events of @proc, called when it exits
+void perf_release(struct proc_struct *proc)
+{
+    struct perf_ctx *ctx;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        ctx = proc->perf;
+        proc->perf = NULL;
+    }
+    local_intr_restore(intr_flag);
+    if (ctx != NULL)
+    {
+        kfree(ctx);
+    }
+}
+
+/* *
+ * do_perf_open - start counting @event for the current process, from 0.
+ * Returns @event, which do_perf_read takes as the handle.
+ * */
+int do_perf_open(int event)
+{
+    if (event < 0 || event >= PERF_NR_EVENTS)
+    {
+        return -E_INVAL;
+    }
+    if (!perf_event_supported(event))
+    {
+        return -E_NA_DEV;
+    }
+    if (current->perf == NULL)
+    {
+        struct perf_ctx *ctx;
+        if ((ctx = kmalloc(sizeof(struct perf_ctx))) == NULL)
+        {
+            return -E_NO_MEM;
+        }
+        memset(ctx, 0, sizeof(struct perf_ctx));
+        current->perf = ctx;
+    }
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        struct perf_ctx *ctx = current->perf;
+        ctx->count[event] = 0;
+        ctx->start[event] = perf_counter_read(event);
+        ctx->open_mask |= 1 << event;
+    }
+    local_intr_restore(intr_flag);
+    return event;
+}
+
+// do_perf_read - store what @event counted for the current process since it was opened
+int do_perf_read(int event, uint64_t *value_store)
+{
+    struct perf_ctx *ctx = current->perf;
+    struct mm_struct *mm = current->mm;
+    uint64_t value;
+    if (event < 0 || event >= PERF_NR_EVENTS || ctx == NULL || !(ctx->open_mask & (1 << event)))
+    {
+        return -E_INVAL;
+    }
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        value = ctx->count[event] + perf_elapsed(event, ctx->start[event]);
+    }
+    local_intr_restore(intr_flag);
+
+    bool ok;
+    mmap_read_lock(mm);
+    {
+        ok = copy_to_user(mm, value_store, &value, sizeof(value));
+    }
+    mmap_read_unlock(mm);
+    return ok ? 0 : -E_INVAL;
+}
@@ -0,0 +1,34 @@
+#ifndef __KERN_DEBUG_PERF_H__
+#define __KERN_DEBUG_PERF_H__
+
+#include <defs.h>
+#include <unistd.h>
+
+struct proc_struct;
+
+/* *
+ * Hardware performance counters. At boot every hart asks the SBI PMU
+ * extension for one free-running counter per PERF_* event (see
+ * libs/unistd.h) it can count; events the platform lacks stay
+ * unavailable. Kernel code reads this hart's counter of an event with
+ * perf_counter_read(). A process that opened events through
+ * SYS_perf_open gets a struct perf_ctx, and proc_run() calls
+ * perf_switch() to charge it only for the time it runs.
+ * */
+struct perf_ctx
+{
+    uint32_t open_mask;                     // bit e: event e is open
+    uint64_t count[PERF_NR_EVENTS];         // counted in earlier time slices
+    uint64_t start[PERF_NR_EVENTS];         // counter value when switched in
+};
+
+void perf_init(void);
+void perf_init_hart(void);
+bool perf_event_supported(int event);
+uint64_t perf_counter_read(int event);
+void perf_switch(struct proc_struct *prev, struct proc_struct *next);
+void perf_release(struct proc_struct *proc);
+int do_perf_open(int event);
+int do_perf_read(int event, uint64_t *value_store);
+
+#endif /* !__KERN_DEBUG_PERF_H__ */
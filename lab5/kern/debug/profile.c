@@ -0,0 +1,162 @@
+#include <defs.h>
+#include <stdio.h>
+#include <string.h>
+#include <smp.h>
+#include <proc.h>
+#include <trap.h>
+#include <profile.h>
+
+struct prof_sample
+{
+    uintptr_t pc;
+    int pid;                        // -1: no process yet
+    bool user;
+};
+
+struct prof_buf
+{
+    struct prof_sample samples[PROF_NR_SAMPLES];
+    size_t nr;                      // samples taken, the ring index is nr % PROF_NR_SAMPLES
+    int skip;                       // ticks left until the next sample
+};
+
+static struct prof_buf prof_bufs[NCPU];
+
+int prof_interval = PROF_INTERVAL;
+
+/* *
+ * profile_tick - called from the timer interrupt with the trapframe of
+ * whatever it interrupted. Only this hart touches its buffer.
+ * */
+void profile_tick(struct trapframe *tf)
+{
+    int interval = prof_interval;
+    struct prof_buf *pb = &prof_bufs[mycpu()->id];
+    if (interval <= 0 || --pb->skip > 0)
+    {
+        return;
+    }
+    pb->skip = interval;
+    struct prof_sample *s = &(pb->samples[pb->nr % PROF_NR_SAMPLES]);
+    s->pc = tf->epc;
+    s->pid = (current != NULL) ? current->pid : -1;
+    s->user = !trap_in_kernel(tf);
+    pb->nr++;
+}
+
+// profile_reset - drop the samples of all harts
+void profile_reset(void)
+{
+    int i;
+    for (i = 0; i < NCPU; i++)
+    {
+        prof_bufs[i].nr = 0;
+    }
+}
+
+/* *
+ * The report folds samples into a hash table of (pc, mode, pid) slots; a
+ * kernel pc counts as one slot whatever process it ran for.
+ * */
+#define PROF_HOT_MAX 1024
+
+struct prof_hot
+{
+    uintptr_t pc;
+    int pid;
+    bool user;
+    int count;
+};
+
+static struct prof_hot prof_hot[PROF_HOT_MAX];
+
+static struct prof_hot *
+prof_hot_lookup(struct prof_sample *s)
+{
+    int pid = s->user ? s->pid : -1;
+    size_t h = ((s->pc >> 1) ^ ((size_t)pid * 0x9e3779b1)) % PROF_HOT_MAX;
+    int n;
+    for (n = 0; n < PROF_HOT_MAX; n++, h = (h + 1) % PROF_HOT_MAX)
+    {
+        struct prof_hot *e = &prof_hot[h];
+        if (e->count == 0)
+        {
+            e->pc = s->pc, e->pid = pid, e->user = s->user;
+            return e;
+        }
+        if (e->pc == s->pc && e->pid == pid && e->user == s->user)
+        {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+// profile_report - print the @top hottest pcs over the samples of all harts
+void profile_report(int top)
+{
+    int total = 0, nr_user = 0, nr_idle = 0, nr_other = 0, i, j;
+    memset(prof_hot, 0, sizeof(prof_hot));
+    for (i = 0; i < ncpu; i++)
+    {
+        struct prof_buf *pb = &prof_bufs[i];
+        size_t nr = (pb->nr < PROF_NR_SAMPLES) ? pb->nr : PROF_NR_SAMPLES;
+        for (j = 0; j < nr; j++)
+        {
+            struct prof_sample *s = &(pb->samples[j]);
+            struct prof_hot *e;
+            total++;
+            if (s->user)
+            {
+                nr_user++;
+            }
+            else if (s->pid == 0)
+            {
+                // the idle loop: worth a line in the summary, not in the list
+                nr_idle++;
+                continue;
+            }
+            if ((e = prof_hot_lookup(s)) == NULL)
+            {
+                nr_other++;
+                continue;
+            }
+            e->count++;
+        }
+    }
+
+    cprintf("profile: %d samples on %d harts, one every %d ticks\n", total, ncpu, prof_interval);
+    if (total == 0)
+    {
+        return;
+    }
+    cprintf("  kernel %d, user %d, idle %d, not listed %d\n",
+            total - nr_user - nr_idle, nr_user, nr_idle, nr_other);
+    cprintf("  count     %%  mode     pid  pc\n");
+    for (i = 0; i < top; i++)
+    {
+        struct prof_hot *best = NULL;
+        for (j = 0; j < PROF_HOT_MAX; j++)
+        {
+            if (prof_hot[j].count > 0 && (best == NULL || prof_hot[j].count > best->count))
+            {
+                best = &prof_hot[j];
+            }
+        }
+        if (best == NULL)
+        {
+            break;
+        }
+        int permille = best->count * 1000 / total;
+        if (best->user)
+        {
+            cprintf("  %5d %3d.%d  user  %6d  0x%016lx\n", best->count, permille / 10, permille % 10, best->pid, best->pc);
+        }
+        else
+        {
+            cprintf("  %5d %3d.%d  kernel     -  0x%016lx\n", best->count, permille / 10, permille % 10, best->pc);
+        }
+        best->count = -best->count;
+    }
+    cprintf("resolve pcs with addr2line -f -e bin/kernel (or obj/__user_<prog>.out).\n");
+}
@@ -0,0 +1,24 @@
+#ifndef __KERN_DEBUG_PROFILE_H__
+#define __KERN_DEBUG_PROFILE_H__
+
+#include <defs.h>
+#include <trap.h>
+
+/* *
+ * Sampling profiler. Every prof_interval-th timer interrupt of a hart
+ * stores the interrupted pc, the pid and the privilege mode into that
+ * hart's sample ring, which costs a few stores and keeps no lock, so it
+ * is on by default. The kernel monitor's `profile' command folds the
+ * samples of all harts into a list of hot pcs.
+ * */
+
+#define PROF_NR_SAMPLES     512         // per hart, the oldest are overwritten
+#define PROF_INTERVAL       1           // default: sample every tick
+
+extern int prof_interval;
+
+void profile_tick(struct trapframe *tf);
+void profile_reset(void);
+void profile_report(int top);
+
+#endif /* !__KERN_DEBUG_PROFILE_H__ */
@@ -0,0 +1,118 @@
+#include <defs.h>
+#include <atomic.h>
+#include <riscv.h>
+#include <stdio.h>
+#include <smp.h>
+#include <proc.h>
+#include <dtb.h>
+#include <trace.h>
+
+#define TRACE_MASK (TRACE_NR_RECORDS - 1)
+
+struct trace_buf
+{
+    struct trace_record records[TRACE_NR_RECORDS];
+    atomic_t nr;            // records written; one amoadd reserves a slot even against a nested trap
+};
+
+static struct trace_buf trace_bufs[NCPU];
+
+volatile uint32_t trace_mask = TRACE_MASK_DEFAULT;
+
+static const char *trace_names[TRACE_NR_EVENTS] = {
+    [TRACE_SCHED] = "sched",
+    [TRACE_SWITCH] = "switch",
+    [TRACE_WAKEUP] = "wakeup",
+    [TRACE_FORK] = "fork",
+    [TRACE_EXEC] = "exec",
+    [TRACE_EXIT] = "exit",
+    [TRACE_SYSCALL] = "syscall",
+    [TRACE_SYSRET] = "sysret",
+    [TRACE_ALLOC_PAGES] = "alloc_pages",
+    [TRACE_TRAP] = "trap",
+};
+
+// trace_event - the body of trace(): fill the next record of this hart's ring
+void trace_event(int type, uint64_t a0, uint64_t a1)
+{
+    struct cpu *cpu = mycpu();
+    struct trace_buf *tb = &trace_bufs[cpu->id];
+    uint32_t idx = (uint32_t)atomic_fetch_add(&(tb->nr), 1);
+    struct trace_record *r = &(tb->records[idx & TRACE_MASK]);
+    r->time = rdtime();
+    r->type = type;
+    r->cpu = cpu->id;
+    r->pid = (current != NULL) ? current->pid : -1;
+    r->a0 = a0;
+    r->a1 = a1;
+}
+
+// trace_clear - drop the records of all harts
+void trace_clear(void)
+{
+    int i;
+    for (i = 0; i < NCPU; i++)
+    {
+        atomic_set(&(trace_bufs[i].nr), 0);
+    }
+}
+
+static void
+trace_print_raw(struct trace_record *r)
+{
+    const uint8_t *p = (const uint8_t *)r;
+    char line[2 * sizeof(struct trace_record) + 1];
+    static const char hex[] = "0123456789abcdef";
+    int i;
+    for (i = 0; i < sizeof(struct trace_record); i++)
+    {
+        line[2 * i] = hex[p[i] >> 4];
+        line[2 * i + 1] = hex[p[i] & 0xf];
+    }
+    line[2 * i] = '\0';
+    cprintf("%s\n", line);
+}
+
+/* *
+ * trace_dump - print the records of every hart, oldest first within a
+ * hart. With @raw, each record is one line of hex between TRACE BEGIN and
+ * TRACE END, to be turned back into binary on the host, e.g.
+ *   sed -n '/^TRACE BEGIN/,/^TRACE END/{/^TRACE/!p}' log | xxd -r -p > trace.bin
+ * The records are not merged across harts; sort on the time field.
+ * */
+void trace_dump(bool raw)
+{
+    uint64_t freq = get_timebase_freq();
+    int i;
+    if (raw)
+    {
+        cprintf("TRACE BEGIN timebase=%lu ncpu=%d record=%d\n", freq, ncpu, (int)sizeof(struct trace_record));
+    }
+    for (i = 0; i < ncpu; i++)
+    {
+        struct trace_buf *tb = &trace_bufs[i];
+        uint32_t nr = (uint32_t)atomic_read(&(tb->nr));
+        uint32_t idx = (nr > TRACE_NR_RECORDS) ? nr - TRACE_NR_RECORDS : 0;
+        for (; idx != nr; idx++)
+        {
+            struct trace_record *r = &(tb->records[idx & TRACE_MASK]);
+            if (raw)
+            {
+                trace_print_raw(r);
+            }
+            else if (r->type < TRACE_NR_EVENTS)
+            {
+                cprintf("%16lu cpu%d pid %4d %-12s 0x%lx 0x%lx\n", r->time, r->cpu, r->pid,
+                        trace_names[r->type], r->a0, r->a1);
+            }
+        }
+    }
+    if (raw)
+    {
+        cprintf("TRACE END\n");
+    }
+    else
+    {
+        cprintf("time in rdtime cycles, %lu per second; mask 0x%x\n", freq, trace_mask);
+    }
+}
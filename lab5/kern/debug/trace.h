@@ -0,0 +1,65 @@
+#ifndef __KERN_DEBUG_TRACE_H__
+#define __KERN_DEBUG_TRACE_H__
+
+#include <defs.h>
+
+/* *
+ * Static tracepoints. trace(ev, a0, a1) appends a fixed-size binary
+ * record, stamped with rdtime, to the ring of the hart it runs on. A
+ * tracepoint whose event is not set in trace_mask costs one load and a
+ * branch that is predicted not taken. Tracing is off after boot unless
+ * the kernel is built with e.g. make DEFS+=-DTRACE_MASK_DEFAULT=TRACE_ALL;
+ * the kernel monitor's `trace' command switches it and dumps the rings,
+ * as text or as hex of the raw records for tools on the host.
+ * */
+
+enum trace_event_type
+{
+    TRACE_SCHED = 0,        // schedule() entered; a0: need_resched, a1: state
+    TRACE_SWITCH,           // proc_run(); a0: prev pid, a1: next pid
+    TRACE_WAKEUP,           // wakeup_proc(); a0: pid, a1: its hart
+    TRACE_FORK,             // do_fork() done; a0: child pid or error, a1: clone_flags
+    TRACE_EXEC,             // do_execve() done; a0: 0 or error
+    TRACE_EXIT,             // do_exit(); a0: error_code
+    TRACE_SYSCALL,          // syscall() entered; a0: number, a1: first argument
+    TRACE_SYSRET,           // syscall() returning; a0: number, a1: return value
+    TRACE_ALLOC_PAGES,      // alloc_pages(); a0: n, a1: physical address or 0
+    TRACE_TRAP,             // trap() entered; a0: scause, a1: sepc
+    TRACE_NR_EVENTS,
+};
+
+#define TRACE_ALL           ((1u << TRACE_NR_EVENTS) - 1)
+
+#ifndef TRACE_MASK_DEFAULT
+#define TRACE_MASK_DEFAULT  0
+#endif
+
+#define TRACE_NR_RECORDS    512         // per hart, a power of two; the oldest are overwritten
+
+// one trace record, 32 bytes in the hart's native (little) endianness
+struct trace_record
+{
+    uint64_t time;          // rdtime
+    uint16_t type;          // enum trace_event_type
+    uint16_t cpu;
+    int32_t pid;            // current, -1 before the first process
+    uint64_t a0;
+    uint64_t a1;
+};
+
+extern volatile uint32_t trace_mask;
+
+void trace_event(int type, uint64_t a0, uint64_t a1);
+void trace_clear(void);
+void trace_dump(bool raw);
+
+#define trace(ev, a0, a1)                                              \
+    do                                                                 \
+    {                                                                  \
+        if (__builtin_expect((trace_mask & (1u << (ev))) != 0, 0))     \
+        {                                                              \
+            trace_event((ev), (uint64_t)(a0), (uint64_t)(a1));         \
+        }                                                              \
+    } while (0)
+
+#endif /* !__KERN_DEBUG_TRACE_H__ */
@@ -3,9 +3,16 @@
 
 #include <defs.h>
 
+/* timer interrupts per second */
+#define TICK_HZ 100
+
 extern volatile size_t ticks;
 
 void clock_init(void);
+void clock_init_hart(void);
 void clock_set_next_event(void);
+void clock_tick_stop(void);
+void clock_tick_restart(void);
+uint64_t clock_cycles_to_usec(uint64_t cycles);
 
 #endif /* !__KERN_DRIVER_CLOCK_H__ */
@@ -1,23 +1,140 @@
 #include <sbi.h>
 #include <sync.h>
 #include <defs.h>
+#include <riscv.h>
+#include <memlayout.h>
+#include <picirq.h>
+#include <proc.h>
+#include <sched.h>
+#include <wait.h>
+#include <uart.h>
 #include <console.h>
 
+/* set by cons_init if the NS16550 UART is driven directly */
+static bool serial_exists = 0;
+/* set by cons_init if the UART interrupt is delivered through the PLIC */
+static bool serial_irq_on = 0;
+/* processes sleeping in cons_wait_input */
+static wait_queue_t cons_wait_queue;
+/* set by cons_init if the firmware implements the SBI Debug Console extension */
+static bool dbcn_present = 0;
+
 /* kbd_intr - try to feed input characters from keyboard */
 void kbd_intr(void) {}
 
 /* serial_intr - try to feed input characters from serial port */
-void serial_intr(void) {}
+void serial_intr(void) {
+    if (serial_exists) {
+        uart_intr();
+        if (!wait_queue_empty(&cons_wait_queue) && uart_rx_pending()) {
+            wakeup_queue(&cons_wait_queue, WT_KBD, 1);
+        }
+    }
+}
+
+static void serial_irq_handler(unsigned int irq, void *arg) {
+    serial_intr();
+}
+
+/* serial_init - take over the UART reported by the DTB, if any */
+static void serial_init(void) {
+    if (uart_init() == 0) {
+        serial_exists = 1;
+        serial_irq_on = (request_irq(uart_irq(), serial_irq_handler, NULL) == 0);
+    }
+}
 
 /* cons_init - initializes the console devices */
-void cons_init(void) {}
+void cons_init(void) {
+    dbcn_present = (sbi_probe_extension(SBI_EXT_DBCN) != 0);
+    wait_queue_init(&cons_wait_queue);
+    serial_init();
+}
 
 /* cons_putc - print a single character @c to console devices */
 void cons_putc(int c) {
+    if (serial_exists) {
+        uart_putc(c);
+        return;
+    }
     bool intr_flag;
     local_intr_save(intr_flag);
     {
-        sbi_console_putchar((unsigned char)c);
+        if (dbcn_present) {
+            sbi_debug_console_write_byte(c);
+        } else {
+            sbi_console_putchar((unsigned char)c);
+        }
+    }
+    local_intr_restore(intr_flag);
+}
+
+/* *
+ * cons_write - print @len characters starting at @buf to console devices.
+ * The UART path only queues them. Through SBI, DBCN takes the whole buffer
+ * to M-mode in a single ecall; otherwise (or for whatever DBCN refuses to
+ * take) fall back to legacy putchar. DBCN wants a physical address, so only
+ * buffers inside the kernel's linear map can be handed over directly.
+ * */
+void cons_write(const char *buf, size_t len) {
+    if (serial_exists) {
+        uart_write(buf, len);
+        return;
+    }
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        if (dbcn_present && KERN_ACCESS((uintptr_t)buf, (uintptr_t)buf + len)) {
+            while (len > 0) {
+                struct sbiret ret = sbi_debug_console_write(
+                    len, (uintptr_t)buf - PHYSICAL_MEMORY_OFFSET);
+                if (ret.error != SBI_SUCCESS || ret.value <= 0) {
+                    break;
+                }
+                buf += ret.value, len -= ret.value;
+            }
+        }
+        while (len > 0) {
+            sbi_console_putchar((unsigned char)*buf++);
+            len--;
+        }
+    }
+    local_intr_restore(intr_flag);
+}
+
+/* cons_flush - wait until all queued output has left the console devices */
+void cons_flush(void) {
+    if (serial_exists) {
+        uart_flush();
+    }
+}
+
+/* *
+ * cons_wait_input - called after cons_getc found nothing. A process sleeps
+ * on cons_wait_queue until the UART interrupt brings input; the idle thread just halts the
+ * hart until the next interrupt. With interrupts disabled (e.g. kmonitor
+ * after a panic) or without an interrupt-driven UART this returns at once
+ * and the caller keeps polling.
+ * */
+void cons_wait_input(void) {
+    if (!serial_irq_on || !(read_csr(sstatus) & SSTATUS_SIE)) {
+        return;
+    }
+    if (current == NULL || current == idleproc) {
+        asm volatile("wfi");
+        return;
+    }
+    bool intr_flag;
+    wait_t __wait, *wait = &__wait;
+    local_intr_save(intr_flag);
+    {
+        if (!uart_rx_pending()) {
+            wait_current_set(&cons_wait_queue, wait, WT_KBD);
+            local_intr_restore(intr_flag);
+            schedule();
+            local_intr_save(intr_flag);
+            wait_current_del(&cons_wait_queue, wait);
+        }
     }
     local_intr_restore(intr_flag);
 }
@@ -27,6 +144,9 @@ void cons_putc(int c) {
  * or 0 if none waiting.
  * */
 int cons_getc(void) {
+    if (serial_exists) {
+        return uart_getc();
+    }
     int c = 0;
     bool intr_flag;
     local_intr_save(intr_flag);
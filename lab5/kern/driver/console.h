@@ -1,9 +1,14 @@
 #ifndef __KERN_DRIVER_CONSOLE_H__
 #define __KERN_DRIVER_CONSOLE_H__
 
+#include <defs.h>
+
 void cons_init(void);
 void cons_putc(int c);
+void cons_write(const char *buf, size_t len);
+void cons_flush(void);
 int cons_getc(void);
+void cons_wait_input(void);
 void serial_intr(void);
 void kbd_intr(void);
 
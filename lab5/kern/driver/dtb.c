@@ -100,10 +100,227 @@ static int extract_memory_info(uintptr_t dtb_vaddr, const struct fdt_header *hea
     }
 }
 
+// 节点嵌套的最大深度
+#define FDT_MAX_DEPTH 16
+
+// 解析单个节点时收集到的属性（只记录驱动关心的那些）
+struct fdt_node_info {
+    const char *name;           // 节点名，如 "serial@10000000"
+    const char *compatible;     // compatible 字符串列表（以 '\0' 分隔）
+    uint32_t compatible_len;
+    uint64_t reg_base;          // reg 的第一组 <地址, 大小>
+    uint64_t reg_size;
+    int has_reg;
+    uint32_t irq;               // interrupts 的第一个中断号
+    int has_irq;
+    uint32_t reg_shift;         // 寄存器间距（ns16550 的 reg-shift）
+    uint32_t ndev;              // 中断源个数（PLIC 的 riscv,ndev）
+    uint64_t timebase_freq;     // timebase-frequency（/cpus 或 cpu 节点）
+    const char *isa;            // riscv,isa 字符串，如 "rv64imafdc_zicsr_sstc"
+    uint32_t isa_len;
+    const char *isa_ext;        // riscv,isa-extensions 字符串列表
+    uint32_t isa_ext_len;
+    uint32_t cboz_block_size;   // riscv,cboz-block-size（Zicboz 一次清零的字节数）
+    const char *bootargs;       // /chosen 的 bootargs（内核命令行）
+    uint32_t bootargs_len;
+};
+
 // 保存解析出的系统物理内存信息
 static uint64_t memory_base = 0;
 static uint64_t memory_size = 0;
 
+// 保存解析出的串口（ns16550a）信息
+static uint64_t uart_base = 0;
+static uint32_t uart_irq = 0;
+static uint32_t uart_reg_shift = 0;
+
+// 保存解析出的平台级中断控制器（PLIC）信息
+static uint64_t plic_base = 0;
+static uint32_t plic_ndev = 0;
+
+// 保存解析出的 CPU 信息。DTB 所在内存稍后会交给页分配器，
+// 所以 ISA 字符串必须拷贝出来，不能只保存指针
+#define ISA_STR_MAX 512
+static uint64_t timebase_freq = 0;
+static char isa_str[ISA_STR_MAX];
+static uint32_t cboz_block_size = 0;
+
+// /chosen/bootargs 的拷贝，DTB 所在内存之后可能被回收
+#define BOOTARGS_MAX 256
+static char bootargs[BOOTARGS_MAX];
+
+// 读取一个按大端存放、可能只 4 字节对齐的 64 位数
+static uint64_t fdt_read64(const uint32_t *p) {
+    return ((uint64_t)fdt32_to_cpu(p[0]) << 32) | fdt32_to_cpu(p[1]);
+}
+
+// compatible 是字符串列表，逐项比较
+static int fdt_node_compatible(const struct fdt_node_info *node, const char *compat) {
+    const char *p = node->compatible;
+    const char *end = p + node->compatible_len;
+    while (p != NULL && p < end) {
+        if (strcmp(p, compat) == 0) {
+            return 1;
+        }
+        p += strlen(p) + 1;
+    }
+    return 0;
+}
+
+// 记录节点中的一个属性
+static void fdt_node_prop(struct fdt_node_info *node, const char *prop_name,
+                          const void *prop_data, uint32_t prop_len) {
+    const uint32_t *cells = (const uint32_t *)prop_data;
+    if (strcmp(prop_name, "compatible") == 0) {
+        node->compatible = (const char *)prop_data;
+        node->compatible_len = prop_len;
+    } else if (strcmp(prop_name, "reg") == 0) {
+        // 假定 #address-cells / #size-cells 与 QEMU virt 一致
+        if (prop_len >= 16) {
+            node->reg_base = fdt_read64(cells);
+            node->reg_size = fdt_read64(cells + 2);
+        } else if (prop_len >= 8) {
+            node->reg_base = fdt_read64(cells);
+        } else if (prop_len >= 4) {
+            node->reg_base = fdt32_to_cpu(cells[0]);
+        }
+        node->has_reg = (prop_len >= 4);
+    } else if (strcmp(prop_name, "interrupts") == 0 && prop_len >= 4) {
+        node->irq = fdt32_to_cpu(cells[0]);
+        node->has_irq = 1;
+    } else if (strcmp(prop_name, "reg-shift") == 0 && prop_len >= 4) {
+        node->reg_shift = fdt32_to_cpu(cells[0]);
+    } else if (strcmp(prop_name, "riscv,ndev") == 0 && prop_len >= 4) {
+        node->ndev = fdt32_to_cpu(cells[0]);
+    } else if (strcmp(prop_name, "timebase-frequency") == 0) {
+        if (prop_len >= 8) {
+            node->timebase_freq = fdt_read64(cells);
+        } else if (prop_len >= 4) {
+            node->timebase_freq = fdt32_to_cpu(cells[0]);
+        }
+    } else if (strcmp(prop_name, "riscv,isa") == 0) {
+        node->isa = (const char *)prop_data;
+        node->isa_len = prop_len;
+    } else if (strcmp(prop_name, "riscv,isa-extensions") == 0) {
+        node->isa_ext = (const char *)prop_data;
+        node->isa_ext_len = prop_len;
+    } else if (strcmp(prop_name, "riscv,cboz-block-size") == 0 && prop_len >= 4) {
+        node->cboz_block_size = fdt32_to_cpu(cells[0]);
+    } else if (strcmp(prop_name, "bootargs") == 0) {
+        node->bootargs = (const char *)prop_data;
+        node->bootargs_len = prop_len;
+    }
+}
+
+// 把 ISA 信息统一保存为以 '_' 分隔的扩展名，
+// riscv,isa-extensions 的每一项都变成一段（优先使用这种新格式）
+static void fdt_save_isa(const struct fdt_node_info *node) {
+    const char *src = (node->isa_ext != NULL) ? node->isa_ext : node->isa;
+    uint32_t len = (node->isa_ext != NULL) ? node->isa_ext_len : node->isa_len;
+    uint32_t i;
+    for (i = 0; i < len && i < ISA_STR_MAX - 1; i++) {
+        char c = src[i];
+        if (c == '\0') {
+            if (i + 1 == len) {
+                break;
+            }
+            c = '_';
+        } else if (c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+        isa_str[i] = c;
+    }
+    isa_str[i] = '\0';
+}
+
+// 节点结束时，根据 compatible 判断是否是我们需要的设备
+static void fdt_node_done(const struct fdt_node_info *node) {
+    if (uart_base == 0 && node->has_reg && fdt_node_compatible(node, "ns16550a")) {
+        uart_base = node->reg_base;
+        uart_irq = node->has_irq ? node->irq : 0;
+        uart_reg_shift = node->reg_shift;
+    }
+    if (plic_base == 0 && node->has_reg &&
+        (fdt_node_compatible(node, "riscv,plic0") ||
+         fdt_node_compatible(node, "sifive,plic-1.0.0"))) {
+        plic_base = node->reg_base;
+        plic_ndev = node->ndev;
+    }
+    // timebase-frequency 一般在 /cpus 节点上，也可能在各 cpu 节点上
+    if (timebase_freq == 0 && node->timebase_freq != 0) {
+        timebase_freq = node->timebase_freq;
+    }
+    if (isa_str[0] == '\0' && (node->isa != NULL || node->isa_ext != NULL) &&
+        fdt_node_compatible(node, "riscv")) {
+        fdt_save_isa(node);
+        cboz_block_size = node->cboz_block_size;
+    }
+    if (node->bootargs != NULL && strcmp(node->name, "chosen") == 0) {
+        uint32_t len = node->bootargs_len;
+        if (len > BOOTARGS_MAX - 1) {
+            len = BOOTARGS_MAX - 1;
+        }
+        memcpy(bootargs, node->bootargs, len);
+        bootargs[len] = '\0';
+    }
+}
+
+// 遍历整棵设备树，提取各设备节点的信息
+static int extract_device_info(uintptr_t dtb_vaddr, const struct fdt_header *header) {
+    uint32_t struct_offset = fdt32_to_cpu(header->off_dt_struct);
+    uint32_t strings_offset = fdt32_to_cpu(header->off_dt_strings);
+
+    const char *strings_base = (const char *)(dtb_vaddr + strings_offset);
+    const uint32_t *struct_ptr = (const uint32_t *)(dtb_vaddr + struct_offset);
+
+    struct fdt_node_info nodes[FDT_MAX_DEPTH];
+    int depth = -1;
+
+    while (1) {
+        uint32_t token = fdt32_to_cpu(*struct_ptr++);
+
+        switch (token) {
+            case FDT_BEGIN_NODE: {
+                const char *name = (const char *)struct_ptr;
+                int name_len = strlen(name);
+                if (++depth < FDT_MAX_DEPTH) {
+                    memset(&nodes[depth], 0, sizeof(struct fdt_node_info));
+                    nodes[depth].name = name;
+                }
+                struct_ptr = (const uint32_t *)(((uintptr_t)struct_ptr + name_len + 4) & ~3);
+                break;
+            }
+
+            case FDT_END_NODE:
+                if (depth >= 0 && depth < FDT_MAX_DEPTH) {
+                    fdt_node_done(&nodes[depth]);
+                }
+                depth--;
+                break;
+
+            case FDT_PROP: {
+                uint32_t prop_len = fdt32_to_cpu(*struct_ptr++);
+                uint32_t prop_nameoff = fdt32_to_cpu(*struct_ptr++);
+                if (depth >= 0 && depth < FDT_MAX_DEPTH) {
+                    fdt_node_prop(&nodes[depth], strings_base + prop_nameoff,
+                                  struct_ptr, prop_len);
+                }
+                struct_ptr = (const uint32_t *)(((uintptr_t)struct_ptr + prop_len + 3) & ~3);
+                break;
+            }
+
+            case FDT_NOP:
+                break;
+
+            case FDT_END:
+                return 0;
+
+            default:
+                return -1; // 错误
+        }
+    }
+}
+
 void dtb_init(void) {
     cprintf("DTB Init\n");
     cprintf("HartID: %ld\n", boot_hartid);
@@ -138,6 +355,28 @@ void dtb_init(void) {
     } else {
         cprintf("Warning: Could not extract memory info from DTB\n");
     }
+
+    // 提取设备信息
+    if (extract_device_info(dtb_vaddr, header) != 0) {
+        cprintf("Warning: Malformed DTB structure block\n");
+    }
+    if (uart_base != 0) {
+        cprintf("UART (ns16550a) from DTB:\n");
+        cprintf("  Base: 0x%016lx, IRQ: %d\n", uart_base, uart_irq);
+    }
+    if (plic_base != 0) {
+        cprintf("PLIC from DTB:\n");
+        cprintf("  Base: 0x%016lx, Sources: %d\n", plic_base, plic_ndev);
+    }
+    if (timebase_freq != 0) {
+        cprintf("CPU timebase: %ld Hz\n", timebase_freq);
+    }
+    if (isa_str[0] != '\0') {
+        cprintf("ISA: %s\n", isa_str);
+    }
+    if (bootargs[0] != '\0') {
+        cprintf("Bootargs: %s\n", bootargs);
+    }
     cprintf("DTB init completed\n");
 }
 
@@ -149,4 +388,101 @@ uint64_t get_memory_size(void) {
     return memory_size;
 }
 
+uint64_t get_uart_base(void) {
+    return uart_base;
+}
+
+uint32_t get_uart_irq(void) {
+    return uart_irq;
+}
+
+uint32_t get_uart_reg_shift(void) {
+    return uart_reg_shift;
+}
+
+uint64_t get_plic_base(void) {
+    return plic_base;
+}
+
+uint32_t get_plic_ndev(void) {
+    return plic_ndev;
+}
+
+uint64_t get_timebase_freq(void) {
+    return timebase_freq;
+}
+
+// Zicboz 的 cbo.zero 一次清零的字节数，DTB 没有给出时为 0
+uint32_t get_cboz_block_size(void) {
+    return cboz_block_size;
+}
+
+// 查询 CPU 是否实现了某个 ISA 扩展，ext 用小写，如 "sstc"、"v"。
+// isa_str 的第一段可能是 "rv64imafdc" 这样的基础 ISA 加单字母扩展
+int dtb_has_isa_ext(const char *ext) {
+    size_t n = strlen(ext);
+    const char *p = isa_str;
+    if (n == 0 || *p == '\0') {
+        return 0;
+    }
+    if (n == 1 && strncmp(p, "rv", 2) == 0) {
+        p += 2;
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+        for (; *p != '\0' && *p != '_'; p++) {
+            if (*p == ext[0]) {
+                return 1;
+            }
+        }
+    }
+    while (*p != '\0') {
+        const char *end = p;
+        while (*end != '\0' && *end != '_') {
+            end++;
+        }
+        if ((size_t)(end - p) == n && strncmp(p, ext, n) == 0) {
+            return 1;
+        }
+        p = (*end == '_') ? end + 1 : end;
+    }
+    return 0;
+}
 
+/* *
+ * dtb_bootarg - 在 bootargs 中查找以空白分隔的参数 @name：
+ * 找不到返回 NULL；"name=value" 把 value 拷入 @buf（最多 @len - 1 个字符）并返回 @buf；
+ * 单独的 "name" 返回空串。
+ * */
+const char *dtb_bootarg(const char *name, char *buf, size_t len) {
+    size_t nlen = strlen(name);
+    const char *p = bootargs;
+    while (*p != '\0') {
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        const char *word = p;
+        while (*p != '\0' && *p != ' ' && *p != '\t') {
+            p++;
+        }
+        if (strncmp(word, name, nlen) != 0) {
+            continue;
+        }
+        if (word + nlen == p) {
+            return "";
+        }
+        if (word[nlen] == '=') {
+            size_t vlen = p - (word + nlen + 1);
+            if (len == 0) {
+                return "";
+            }
+            if (vlen > len - 1) {
+                vlen = len - 1;
+            }
+            memcpy(buf, word + nlen + 1, vlen);
+            buf[vlen] = '\0';
+            return buf;
+        }
+    }
+    return NULL;
+}
@@ -10,6 +10,15 @@ extern uint64_t boot_dtb;
 void dtb_init(void);
 uint64_t get_memory_base(void);
 uint64_t get_memory_size(void);
+uint64_t get_uart_base(void);
+uint32_t get_uart_irq(void);
+uint32_t get_uart_reg_shift(void);
+uint64_t get_plic_base(void);
+uint32_t get_plic_ndev(void);
+uint64_t get_timebase_freq(void);
+uint32_t get_cboz_block_size(void);
+int dtb_has_isa_ext(const char *ext);
+const char *dtb_bootarg(const char *name, char *buf, size_t len);
 
 #endif /* !__KERN_DRIVER_DTB_H__ */
 
@@ -1,6 +1,198 @@
+#include <defs.h>
+#include <riscv.h>
+#include <memlayout.h>
+#include <error.h>
+#include <stdio.h>
+#include <sync.h>
+#include <dtb.h>
 #include <picirq.h>
 
-void pic_enable(unsigned int irq) {}
+/* *
+ * Driver for the RISC-V Platform-Level Interrupt Controller.
+ *
+ * Every external interrupt reaches the hart as IRQ_S_EXT; pic_dispatch then
+ * claims the pending source from the PLIC, calls the handler registered for
+ * it with request_irq, and completes it. Each source counts how often it
+ * fired so that interrupt load can be inspected from kmonitor.
+ * */
 
-/* pic_init - initialize the 8259A interrupt controllers */
-void pic_init(void) {}
+/* register layout, relative to the PLIC base */
+#define PLIC_PRIORITY(irq) (0x4 * (irq))
+#define PLIC_ENABLE(ctx) (0x2000 + 0x80 * (ctx))
+#define PLIC_THRESHOLD(ctx) (0x200000 + 0x1000 * (ctx))
+#define PLIC_CLAIM(ctx) (0x200004 + 0x1000 * (ctx))
+
+/* *
+ * QEMU virt gives every hart an M-mode context followed by an S-mode one,
+ * so the S-mode context of hart h is 2h + 1.
+ * */
+#define PLIC_SCONTEXT(hartid) (2 * (hartid) + 1)
+
+struct irq_desc
+{
+    irq_handler_t handler; // called with interrupts disabled
+    void *arg;             // passed back to handler
+    size_t count;          // number of times this source was claimed
+};
+
+static struct irq_desc irq_desc[NR_IRQS];
+static size_t spurious_count = 0;
+
+static uintptr_t plic_regs = 0;
+static unsigned int plic_ndev = 0;
+static unsigned int plic_context = 0;
+
+static inline volatile uint32_t *
+plic_reg(uintptr_t off)
+{
+    return (volatile uint32_t *)(plic_regs + off);
+}
+
+/* pic_init - find the PLIC in the DTB and enable supervisor external interrupts */
+void pic_init(void)
+{
+    uint64_t base = get_plic_base();
+    if (base == 0 || base >= KIOSIZE)
+    {
+        cprintf("pic_init: no PLIC, external interrupts disabled\n");
+        return;
+    }
+    plic_regs = IOADDR(base);
+    plic_ndev = get_plic_ndev();
+    if (plic_ndev == 0 || plic_ndev >= NR_IRQS)
+    {
+        plic_ndev = NR_IRQS - 1;
+    }
+    plic_context = PLIC_SCONTEXT(boot_hartid);
+
+    // start with every source disabled, and let any priority > 0 through
+    unsigned int irq;
+    for (irq = 1; irq <= plic_ndev; irq++)
+    {
+        *plic_reg(PLIC_PRIORITY(irq)) = 0;
+    }
+    for (irq = 0; irq <= plic_ndev; irq += 32)
+    {
+        *plic_reg(PLIC_ENABLE(plic_context) + (irq / 32) * 4) = 0;
+    }
+    *plic_reg(PLIC_THRESHOLD(plic_context)) = 0;
+
+    set_csr(sie, MIP_SEIP);
+}
+
+/* pic_enable - let interrupt source @irq reach this hart */
+void pic_enable(unsigned int irq)
+{
+    if (plic_regs == 0 || irq == 0 || irq > plic_ndev)
+    {
+        return;
+    }
+    *plic_reg(PLIC_PRIORITY(irq)) = 1;
+    *plic_reg(PLIC_ENABLE(plic_context) + (irq / 32) * 4) |= (1U << (irq % 32));
+}
+
+/* pic_disable - stop interrupt source @irq from reaching this hart */
+void pic_disable(unsigned int irq)
+{
+    if (plic_regs == 0 || irq == 0 || irq > plic_ndev)
+    {
+        return;
+    }
+    *plic_reg(PLIC_ENABLE(plic_context) + (irq / 32) * 4) &= ~(1U << (irq % 32));
+}
+
+/* *
+ * request_irq - call @handler(@irq, @arg) whenever source @irq fires, and
+ * enable the source. Returns -E_NO_DEV if there is no PLIC, -E_INVAL for a
+ * bad source number and -E_BUSY if the source already has a handler.
+ * */
+int request_irq(unsigned int irq, irq_handler_t handler, void *arg)
+{
+    if (plic_regs == 0)
+    {
+        return -E_NO_DEV;
+    }
+    if (irq == 0 || irq > plic_ndev || handler == NULL)
+    {
+        return -E_INVAL;
+    }
+    int ret = -E_BUSY;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        if (irq_desc[irq].handler == NULL)
+        {
+            irq_desc[irq].handler = handler;
+            irq_desc[irq].arg = arg;
+            irq_desc[irq].count = 0;
+            pic_enable(irq);
+            ret = 0;
+        }
+    }
+    local_intr_restore(intr_flag);
+    return ret;
+}
+
+/* free_irq - disable source @irq and forget its handler */
+void free_irq(unsigned int irq)
+{
+    if (irq == 0 || irq >= NR_IRQS)
+    {
+        return;
+    }
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        pic_disable(irq);
+        irq_desc[irq].handler = NULL;
+        irq_desc[irq].arg = NULL;
+    }
+    local_intr_restore(intr_flag);
+}
+
+/* *
+ * pic_dispatch - handle IRQ_S_EXT: claim and serve every pending source.
+ * Called from interrupt_handler with interrupts disabled.
+ * */
+void pic_dispatch(void)
+{
+    if (plic_regs == 0)
+    {
+        return;
+    }
+    uint32_t irq;
+    while ((irq = *plic_reg(PLIC_CLAIM(plic_context))) != 0)
+    {
+        if (irq < NR_IRQS && irq_desc[irq].handler != NULL)
+        {
+            irq_desc[irq].count++;
+            irq_desc[irq].handler(irq, irq_desc[irq].arg);
+        }
+        else
+        {
+            spurious_count++;
+        }
+        *plic_reg(PLIC_CLAIM(plic_context)) = irq;
+    }
+}
+
+/* irq_count - the number of times source @irq has been served */
+size_t irq_count(unsigned int irq)
+{
+    return (irq < NR_IRQS) ? irq_desc[irq].count : 0;
+}
+
+/* print_irq_stats - print the counter of every source with a handler */
+void print_irq_stats(void)
+{
+    unsigned int irq;
+    cprintf("IRQ  count\n");
+    for (irq = 1; irq < NR_IRQS; irq++)
+    {
+        if (irq_desc[irq].handler != NULL || irq_desc[irq].count != 0)
+        {
+            cprintf("%3d  %ld\n", irq, irq_desc[irq].count);
+        }
+    }
+    cprintf("spurious  %ld\n", spurious_count);
+}
@@ -1,8 +1,21 @@
 #ifndef __KERN_DRIVER_PICIRQ_H__
 #define __KERN_DRIVER_PICIRQ_H__
 
+#include <defs.h>
+
+/* the largest number of interrupt sources we dispatch */
+#define NR_IRQS 128
+
+typedef void (*irq_handler_t)(unsigned int irq, void *arg);
+
 void pic_init(void);
 void pic_enable(unsigned int irq);
+void pic_disable(unsigned int irq);
+void pic_dispatch(void);
 
-#endif /* !__KERN_DRIVER_PICIRQ_H__ */
+int request_irq(unsigned int irq, irq_handler_t handler, void *arg);
+void free_irq(unsigned int irq);
+size_t irq_count(unsigned int irq);
+void print_irq_stats(void);
 
+#endif /* !__KERN_DRIVER_PICIRQ_H__ */
@@ -0,0 +1,238 @@
+#include <defs.h>
+#include <sync.h>
+#include <memlayout.h>
+#include <dtb.h>
+#include <uart.h>
+
+/* *
+ * Interrupt-driven driver for the NS16550A UART of QEMU virt.
+ *
+ * Output is queued into a TX ring and returns at once; the transmit FIFO
+ * is refilled whenever the UART raises a THR-empty interrupt (or whenever
+ * a writer finds it empty). Input is moved from the receive FIFO into an
+ * RX ring by the interrupt handler and consumed by uart_getc.
+ * Only when the TX ring is full does a writer wait for the device.
+ * The interrupt is delivered through the PLIC (see kern/driver/picirq.c).
+ * */
+
+/* register offsets (before reg-shift) */
+#define UART_RBR 0 // receive buffer (read)
+#define UART_THR 0 // transmit holding (write)
+#define UART_IER 1 // interrupt enable
+#define UART_IIR 2 // interrupt identification (read)
+#define UART_FCR 2 // FIFO control (write)
+#define UART_LCR 3 // line control
+#define UART_MCR 4 // modem control
+#define UART_LSR 5 // line status
+
+#define UART_IER_RDI 0x01  // enable receiver data interrupt
+#define UART_IER_THRI 0x02 // enable transmitter holding register empty interrupt
+
+#define UART_FCR_ENABLE 0x01     // enable the FIFOs
+#define UART_FCR_CLEAR_RCVR 0x02 // clear the receive FIFO
+#define UART_FCR_CLEAR_XMIT 0x04 // clear the transmit FIFO
+
+#define UART_MCR_OUT2 0x08 // route the interrupt line to the interrupt controller
+
+#define UART_LSR_DR 0x01   // receiver data ready
+#define UART_LSR_THRE 0x20 // transmit holding register (FIFO) empty
+
+#define UART_FIFO_DEPTH 16
+
+/* ring sizes must be powers of 2 */
+#define UART_TX_BUFSIZE 1024
+#define UART_RX_BUFSIZE 256
+
+struct uart_ring
+{
+    uint32_t head; // next slot to fill
+    uint32_t tail; // next slot to drain
+};
+
+static uintptr_t uart_regs = 0;
+static uint32_t uart_shift = 0;
+static uint32_t uart_irqno = 0;
+
+static struct uart_ring tx_ring, rx_ring;
+static char tx_buf[UART_TX_BUFSIZE];
+static char rx_buf[UART_RX_BUFSIZE];
+
+#define ring_count(r) ((r)->head - (r)->tail)
+
+static inline uint8_t
+uart_read(int reg)
+{
+    return *(volatile uint8_t *)(uart_regs + (reg << uart_shift));
+}
+
+static inline void
+uart_write_reg(int reg, uint8_t val)
+{
+    *(volatile uint8_t *)(uart_regs + (reg << uart_shift)) = val;
+}
+
+/* *
+ * uart_tx_start - move queued characters into the transmit FIFO if it is
+ * empty, and ask for a THRE interrupt while anything is left queued.
+ * Must be called with interrupts disabled.
+ * */
+static void
+uart_tx_start(void)
+{
+    if (ring_count(&tx_ring) != 0 && (uart_read(UART_LSR) & UART_LSR_THRE))
+    {
+        int n = UART_FIFO_DEPTH;
+        while (n-- > 0 && ring_count(&tx_ring) != 0)
+        {
+            uart_write_reg(UART_THR, tx_buf[tx_ring.tail++ & (UART_TX_BUFSIZE - 1)]);
+        }
+    }
+    uart_write_reg(UART_IER, UART_IER_RDI | (ring_count(&tx_ring) != 0 ? UART_IER_THRI : 0));
+}
+
+/* uart_rx_drain - move everything in the receive FIFO into the RX ring */
+static void
+uart_rx_drain(void)
+{
+    while (uart_read(UART_LSR) & UART_LSR_DR)
+    {
+        char c = uart_read(UART_RBR);
+        if (ring_count(&rx_ring) < UART_RX_BUFSIZE)
+        {
+            rx_buf[rx_ring.head++ & (UART_RX_BUFSIZE - 1)] = c;
+        }
+    }
+}
+
+/* *
+ * uart_init - find the UART in the DTB and set up its FIFOs and interrupts.
+ * Returns 0 on success, or -1 if there is no UART to drive.
+ * */
+int uart_init(void)
+{
+    uint64_t base = get_uart_base();
+    if (base == 0 || base + 8 > KIOSIZE)
+    {
+        return -1;
+    }
+    uart_regs = IOADDR(base);
+    uart_shift = get_uart_reg_shift();
+    uart_irqno = get_uart_irq();
+    tx_ring.head = tx_ring.tail = 0;
+    rx_ring.head = rx_ring.tail = 0;
+
+    // keep the line settings chosen by the firmware, only reset the FIFOs
+    uart_write_reg(UART_FCR, UART_FCR_ENABLE | UART_FCR_CLEAR_RCVR | UART_FCR_CLEAR_XMIT);
+    uart_write_reg(UART_MCR, uart_read(UART_MCR) | UART_MCR_OUT2);
+    uart_write_reg(UART_IER, UART_IER_RDI);
+    return 0;
+}
+
+/* uart_irq - the interrupt source number of the UART */
+uint32_t uart_irq(void)
+{
+    return uart_irqno;
+}
+
+/* uart_intr - UART interrupt handler: fill the RX ring, refill the TX FIFO */
+void uart_intr(void)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        uart_rx_drain();
+        uart_tx_start();
+    }
+    local_intr_restore(intr_flag);
+}
+
+/* *
+ * uart_putc - queue @c for output. Only if the TX ring is full do we wait
+ * for the device to take a character.
+ * */
+void uart_putc(int c)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        while (ring_count(&tx_ring) == UART_TX_BUFSIZE)
+        {
+            uart_tx_start();
+        }
+        tx_buf[tx_ring.head++ & (UART_TX_BUFSIZE - 1)] = c;
+        uart_tx_start();
+    }
+    local_intr_restore(intr_flag);
+}
+
+/* uart_write - queue @len characters at @buf for output */
+void uart_write(const char *buf, size_t len)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        while (len > 0)
+        {
+            while (ring_count(&tx_ring) == UART_TX_BUFSIZE)
+            {
+                uart_tx_start();
+            }
+            while (len > 0 && ring_count(&tx_ring) < UART_TX_BUFSIZE)
+            {
+                tx_buf[tx_ring.head++ & (UART_TX_BUFSIZE - 1)] = *buf++;
+                len--;
+            }
+            uart_tx_start();
+        }
+    }
+    local_intr_restore(intr_flag);
+}
+
+/* *
+ * uart_getc - return the next received character, or 0 if none waiting.
+ * The receive FIFO is polled too, so input works before the interrupt
+ * line is routed and while interrupts are disabled (e.g. in kmonitor).
+ * */
+int uart_getc(void)
+{
+    int c = 0;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        uart_rx_drain();
+        if (ring_count(&rx_ring) != 0)
+        {
+            c = (unsigned char)rx_buf[rx_ring.tail++ & (UART_RX_BUFSIZE - 1)];
+        }
+    }
+    local_intr_restore(intr_flag);
+    return c;
+}
+
+/* uart_rx_pending - return non-zero if uart_getc has a character to return */
+int uart_rx_pending(void)
+{
+    int pending;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        uart_rx_drain();
+        pending = (ring_count(&rx_ring) != 0);
+    }
+    local_intr_restore(intr_flag);
+    return pending;
+}
+
+/* uart_flush - synchronously push out everything queued, e.g. before shutdown */
+void uart_flush(void)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        while (ring_count(&tx_ring) != 0)
+        {
+            uart_tx_start();
+        }
+    }
+    local_intr_restore(intr_flag);
+}
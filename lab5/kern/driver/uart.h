@@ -0,0 +1,15 @@
+#ifndef __KERN_DRIVER_UART_H__
+#define __KERN_DRIVER_UART_H__
+
+#include <defs.h>
+
+int uart_init(void);
+void uart_intr(void);
+void uart_putc(int c);
+void uart_write(const char *buf, size_t len);
+int uart_getc(void);
+int uart_rx_pending(void);
+void uart_flush(void);
+uint32_t uart_irq(void);
+
+#endif /* !__KERN_DRIVER_UART_H__ */
@@ -0,0 +1,257 @@
+#include <defs.h>
+#include <sync.h>
+#include <proc.h>
+#include <vmm.h>
+#include <kmalloc.h>
+#include <string.h>
+#include <error.h>
+#include <assert.h>
+#include <pipe.h>
+#include <file.h>
+
+static struct file *
+file_alloc(void)
+{
+    struct file *file;
+    if ((file = kmalloc(sizeof(struct file))) != NULL)
+    {
+        file->type = FD_NONE;
+        file->readable = file->writable = 0;
+        file->ref = 1;
+        file->pipe = NULL;
+    }
+    return file;
+}
+
+// file_put - drop a reference to @file, closing it with the last one
+static void
+file_put(struct file *file)
+{
+    bool intr_flag, last;
+    local_intr_save(intr_flag);
+    {
+        assert(file->ref > 0);
+        last = (--file->ref == 0);
+    }
+    local_intr_restore(intr_flag);
+    if (last)
+    {
+        if (file->type == FD_PIPE)
+        {
+            pipe_close(file->pipe, file->writable);
+        }
+        kfree(file);
+    }
+}
+
+// files_create - allocate an empty descriptor table
+struct files_struct *
+files_create(void)
+{
+    struct files_struct *filesp;
+    if ((filesp = kmalloc(sizeof(struct files_struct))) != NULL)
+    {
+        filesp->count = 0;
+        memset(filesp->fd_array, 0, sizeof(filesp->fd_array));
+    }
+    return filesp;
+}
+
+// files_destroy - close every descriptor in @filesp and free it
+void files_destroy(struct files_struct *filesp)
+{
+    assert(filesp != NULL && filesp->count == 0);
+    int fd;
+    for (fd = 0; fd < FILES_STRUCT_NENTRY; fd++)
+    {
+        if (filesp->fd_array[fd] != NULL)
+        {
+            file_put(filesp->fd_array[fd]);
+        }
+    }
+    kfree(filesp);
+}
+
+// dup_files - make @to refer to the same open files as @from, for fork
+int dup_files(struct files_struct *to, struct files_struct *from)
+{
+    assert(to != NULL && from != NULL);
+    int fd;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        for (fd = 0; fd < FILES_STRUCT_NENTRY; fd++)
+        {
+            if ((to->fd_array[fd] = from->fd_array[fd]) != NULL)
+            {
+                to->fd_array[fd]->ref++;
+            }
+        }
+    }
+    local_intr_restore(intr_flag);
+    return 0;
+}
+
+// fd_install - put @file into the lowest free slot of current's table
+static int
+fd_install(struct file *file)
+{
+    struct files_struct *filesp = current->filesp;
+    int fd, ret = -E_MAX_OPEN;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        for (fd = 0; fd < FILES_STRUCT_NENTRY; fd++)
+        {
+            if (filesp->fd_array[fd] == NULL)
+            {
+                filesp->fd_array[fd] = file;
+                ret = fd;
+                break;
+            }
+        }
+    }
+    local_intr_restore(intr_flag);
+    return ret;
+}
+
+// fd2file - look up @fd and take a reference to its file, NULL if not open
+static struct file *
+fd2file(int fd)
+{
+    struct files_struct *filesp = current->filesp;
+    struct file *file = NULL;
+    if (filesp != NULL && fd >= 0 && fd < FILES_STRUCT_NENTRY)
+    {
+        bool intr_flag;
+        local_intr_save(intr_flag);
+        {
+            if ((file = filesp->fd_array[fd]) != NULL)
+            {
+                file->ref++;
+            }
+        }
+        local_intr_restore(intr_flag);
+    }
+    return file;
+}
+
+// sysfile_pipe - create a pipe, store its read and write descriptors in fd_store[0] and fd_store[1]
+int sysfile_pipe(int *fd_store)
+{
+    struct mm_struct *mm = current->mm;
+    if (current->filesp == NULL)
+    {
+        return -E_INVAL;
+    }
+    int ret = -E_NO_MEM, fd[2];
+    struct file *rfile, *wfile;
+    struct pipe *pipe;
+    if ((rfile = file_alloc()) == NULL)
+    {
+        goto out;
+    }
+    if ((wfile = file_alloc()) == NULL)
+    {
+        goto bad_cleanup_rfile;
+    }
+    if ((pipe = pipe_create()) == NULL)
+    {
+        goto bad_cleanup_wfile;
+    }
+    pipe->readers = pipe->writers = 1;
+    rfile->type = wfile->type = FD_PIPE;
+    rfile->pipe = wfile->pipe = pipe;
+    rfile->readable = 1;
+    wfile->writable = 1;
+
+    if ((ret = fd[0] = fd_install(rfile)) < 0)
+    {
+        file_put(rfile);
+        file_put(wfile);
+        goto out;
+    }
+    if ((ret = fd[1] = fd_install(wfile)) < 0)
+    {
+        sysfile_close(fd[0]);
+        file_put(wfile);
+        goto out;
+    }
+    bool ok;
+    mmap_read_lock(mm);
+    {
+        ok = copy_to_user(mm, fd_store, fd, sizeof(fd));
+    }
+    mmap_read_unlock(mm);
+    if (!ok)
+    {
+        sysfile_close(fd[0]);
+        sysfile_close(fd[1]);
+        return -E_INVAL;
+    }
+    return 0;
+
+bad_cleanup_wfile:
+    kfree(wfile);
+bad_cleanup_rfile:
+    kfree(rfile);
+out:
+    return ret;
+}
+
+// sysfile_read - read up to @len bytes from @fd into user buffer @base
+int sysfile_read(int fd, void *base, size_t len)
+{
+    struct file *file;
+    if ((file = fd2file(fd)) == NULL)
+    {
+        return -E_INVAL;
+    }
+    int ret = -E_INVAL;
+    if (file->readable && file->type == FD_PIPE)
+    {
+        ret = pipe_read(file->pipe, base, len);
+    }
+    file_put(file);
+    return ret;
+}
+
+// sysfile_write - write @len bytes from user buffer @base to @fd
+int sysfile_write(int fd, const void *base, size_t len)
+{
+    struct file *file;
+    if ((file = fd2file(fd)) == NULL)
+    {
+        return -E_INVAL;
+    }
+    int ret = -E_INVAL;
+    if (file->writable && file->type == FD_PIPE)
+    {
+        ret = pipe_write(file->pipe, base, len);
+    }
+    file_put(file);
+    return ret;
+}
+
+// sysfile_close - free descriptor @fd; the file is closed once nothing else refers to it
+int sysfile_close(int fd)
+{
+    struct files_struct *filesp = current->filesp;
+    struct file *file = NULL;
+    if (filesp != NULL && fd >= 0 && fd < FILES_STRUCT_NENTRY)
+    {
+        bool intr_flag;
+        local_intr_save(intr_flag);
+        {
+            file = filesp->fd_array[fd];
+            filesp->fd_array[fd] = NULL;
+        }
+        local_intr_restore(intr_flag);
+    }
+    if (file == NULL)
+    {
+        return -E_INVAL;
+    }
+    file_put(file);
+    return 0;
+}
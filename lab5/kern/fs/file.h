@@ -0,0 +1,77 @@
+#ifndef __KERN_FS_FILE_H__
+#define __KERN_FS_FILE_H__
+
+#include <defs.h>
+#include <sync.h>
+
+struct pipe;
+struct proc_struct;
+
+/* *
+ * An open file. Several descriptors (in one or several processes) may
+ * refer to the same file; ref counts them, plus any syscall currently
+ * using it, and the file is released with its last reference.
+ * */
+enum file_type
+{
+    FD_NONE,
+    FD_PIPE,
+};
+
+struct file
+{
+    enum file_type type;
+    bool readable;
+    bool writable;
+    int ref;
+    struct pipe *pipe;          // FD_PIPE
+};
+
+// the maximum number of descriptors a process can have open
+#define FILES_STRUCT_NENTRY 16
+
+/* *
+ * The descriptor table of a process, hung off proc_struct. It is copied on
+ * fork and shared between threads created with CLONE_FS; count is the
+ * number of processes sharing it. Kernel threads have none until they
+ * exec a user program.
+ * */
+struct files_struct
+{
+    int count;
+    struct file *fd_array[FILES_STRUCT_NENTRY];
+};
+
+struct files_struct *files_create(void);
+void files_destroy(struct files_struct *filesp);
+int dup_files(struct files_struct *to, struct files_struct *from);
+
+// the count is shared by threads that may be preempted, update it atomically
+static inline int
+files_count_inc(struct files_struct *filesp)
+{
+    bool intr_flag;
+    int count;
+    local_intr_save(intr_flag);
+    count = (filesp->count += 1);
+    local_intr_restore(intr_flag);
+    return count;
+}
+
+static inline int
+files_count_dec(struct files_struct *filesp)
+{
+    bool intr_flag;
+    int count;
+    local_intr_save(intr_flag);
+    count = (filesp->count -= 1);
+    local_intr_restore(intr_flag);
+    return count;
+}
+
+int sysfile_pipe(int *fd_store);
+int sysfile_read(int fd, void *base, size_t len);
+int sysfile_write(int fd, const void *base, size_t len);
+int sysfile_close(int fd);
+
+#endif /* !__KERN_FS_FILE_H__ */
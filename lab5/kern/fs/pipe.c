@@ -0,0 +1,213 @@
+#include <defs.h>
+#include <sync.h>
+#include <wait.h>
+#include <sem.h>
+#include <proc.h>
+#include <sched.h>
+#include <pmm.h>
+#include <vmm.h>
+#include <kmalloc.h>
+#include <error.h>
+#include <assert.h>
+#include <pipe.h>
+
+// pipe_create - allocate an empty pipe with no open ends
+struct pipe *
+pipe_create(void)
+{
+    struct pipe *pipe;
+    if ((pipe = kmalloc(sizeof(struct pipe))) != NULL)
+    {
+        struct Page *page;
+        if ((page = alloc_pages(PIPE_NPAGES)) == NULL)
+        {
+            kfree(pipe);
+            return NULL;
+        }
+        pipe->buf = page2kva(page);
+        pipe->head = pipe->tail = 0;
+        pipe->readers = pipe->writers = 0;
+        wait_queue_init(&(pipe->read_queue));
+        wait_queue_init(&(pipe->write_queue));
+        sem_init(&(pipe->rlock), 1);
+        sem_init(&(pipe->wlock), 1);
+    }
+    return pipe;
+}
+
+// pipe_close - drop one read or write end; the pipe is freed with its last end
+void pipe_close(struct pipe *pipe, bool writable)
+{
+    bool intr_flag, last;
+    local_intr_save(intr_flag);
+    {
+        if (writable)
+        {
+            assert(pipe->writers > 0);
+            // readers see end-of-file once the last writer is gone
+            if (--pipe->writers == 0)
+            {
+                wakeup_queue(&(pipe->read_queue), WT_PIPE, 1);
+            }
+        }
+        else
+        {
+            assert(pipe->readers > 0);
+            // writers see a broken pipe once the last reader is gone
+            if (--pipe->readers == 0)
+            {
+                wakeup_queue(&(pipe->write_queue), WT_PIPE, 1);
+            }
+        }
+        last = (pipe->readers == 0 && pipe->writers == 0);
+    }
+    local_intr_restore(intr_flag);
+    if (last)
+    {
+        free_pages(kva2page(pipe->buf), PIPE_NPAGES);
+        kfree(pipe);
+    }
+}
+
+/* *
+ * pipe_wait - sleep on @queue until the other end makes progress. Returns
+ * -E_KILLED if the process was killed meanwhile. The caller has checked the
+ * pipe state with interrupts disabled and passes the saved flag along.
+ * */
+static int
+pipe_wait(wait_queue_t *queue, bool intr_flag)
+{
+    wait_t __wait, *wait = &__wait;
+    wait_current_set(queue, wait, WT_PIPE);
+    local_intr_restore(intr_flag);
+
+    schedule();
+
+    local_intr_save(intr_flag);
+    wait_current_del(queue, wait);
+    local_intr_restore(intr_flag);
+    if (wait->wakeup_flags != WT_PIPE && (current->flags & PF_EXITING))
+    {
+        return -E_KILLED;
+    }
+    return 0;
+}
+
+/* *
+ * pipe_read - read up to @len bytes into user buffer @base. Sleeps while
+ * the pipe is empty and has writers; returns as soon as some data has
+ * been read, 0 at end-of-file. Data is copied at most a page at a time.
+ * */
+int pipe_read(struct pipe *pipe, void *base, size_t len)
+{
+    struct mm_struct *mm = current->mm;
+    size_t copied = 0;
+    int ret = 0;
+    bool intr_flag;
+    down(&(pipe->rlock));
+    while (copied < len)
+    {
+        local_intr_save(intr_flag);
+        size_t avail = pipe->tail - pipe->head;
+        if (avail == 0)
+        {
+            if (copied > 0 || pipe->writers == 0)
+            {
+                local_intr_restore(intr_flag);
+                break;
+            }
+            if ((ret = pipe_wait(&(pipe->read_queue), intr_flag)) != 0)
+            {
+                break;
+            }
+            continue;
+        }
+        local_intr_restore(intr_flag);
+
+        size_t off = pipe->head % PIPE_SIZE, n = len - copied;
+        n = (n < avail) ? n : avail;
+        n = (n < PIPE_SIZE - off) ? n : PIPE_SIZE - off;
+        n = (n < PGSIZE) ? n : PGSIZE;
+        bool ok;
+        mmap_read_lock(mm);
+        {
+            ok = copy_to_user(mm, (char *)base + copied, pipe->buf + off, n);
+        }
+        mmap_read_unlock(mm);
+        if (!ok)
+        {
+            ret = -E_INVAL;
+            break;
+        }
+        copied += n;
+
+        local_intr_save(intr_flag);
+        {
+            pipe->head += n;
+            wakeup_queue(&(pipe->write_queue), WT_PIPE, 1);
+        }
+        local_intr_restore(intr_flag);
+    }
+    up(&(pipe->rlock));
+    return (copied > 0) ? copied : ret;
+}
+
+/* *
+ * pipe_write - write all @len bytes from user buffer @base, sleeping while
+ * the pipe is full. Returns -E_PIPE if there are no readers left before
+ * anything was written, otherwise the number of bytes written.
+ * */
+int pipe_write(struct pipe *pipe, const void *base, size_t len)
+{
+    struct mm_struct *mm = current->mm;
+    size_t copied = 0;
+    int ret = 0;
+    bool intr_flag;
+    down(&(pipe->wlock));
+    while (copied < len)
+    {
+        local_intr_save(intr_flag);
+        if (pipe->readers == 0)
+        {
+            local_intr_restore(intr_flag);
+            ret = -E_PIPE;
+            break;
+        }
+        size_t space = PIPE_SIZE - (pipe->tail - pipe->head);
+        if (space == 0)
+        {
+            if ((ret = pipe_wait(&(pipe->write_queue), intr_flag)) != 0)
+            {
+                break;
+            }
+            continue;
+        }
+        local_intr_restore(intr_flag);
+
+        size_t off = pipe->tail % PIPE_SIZE, n = len - copied;
+        n = (n < space) ? n : space;
+        n = (n < PIPE_SIZE - off) ? n : PIPE_SIZE - off;
+        n = (n < PGSIZE) ? n : PGSIZE;
+        bool ok;
+        mmap_read_lock(mm);
+        {
+            ok = copy_from_user(mm, pipe->buf + off, (const char *)base + copied, n, 0);
+        }
+        mmap_read_unlock(mm);
+        if (!ok)
+        {
+            ret = -E_INVAL;
+            break;
+        }
+        copied += n;
+
+        local_intr_save(intr_flag);
+        {
+            pipe->tail += n;
+            wakeup_queue(&(pipe->read_queue), WT_PIPE, 1);
+        }
+        local_intr_restore(intr_flag);
+    }
+    up(&(pipe->wlock));
+    return (copied > 0) ? copied : ret;
+}
@@ -0,0 +1,38 @@
+#ifndef __KERN_FS_PIPE_H__
+#define __KERN_FS_PIPE_H__
+
+#include <defs.h>
+#include <wait.h>
+#include <sem.h>
+#include <mmu.h>
+
+/* *
+ * A pipe is a ring buffer of PIPE_NPAGES contiguous kernel pages. head and
+ * tail are free-running byte counters: the reader only advances head, the
+ * writer only advances tail, and tail - head bytes are buffered. Readers
+ * sleep on read_queue while the pipe is empty, writers on write_queue
+ * while it is full. rlock/wlock keep concurrent readers (writers) from
+ * interleaving their data.
+ * */
+#define PIPE_NPAGES 4
+#define PIPE_SIZE (PIPE_NPAGES * PGSIZE)
+
+struct pipe
+{
+    char *buf;                  // PIPE_SIZE bytes
+    size_t head;                // total bytes read
+    size_t tail;                // total bytes written
+    int readers;                // open read ends
+    int writers;                // open write ends
+    wait_queue_t read_queue;
+    wait_queue_t write_queue;
+    semaphore_t rlock;
+    semaphore_t wlock;
+};
+
+struct pipe *pipe_create(void);
+void pipe_close(struct pipe *pipe, bool writable);
+int pipe_read(struct pipe *pipe, void *base, size_t len);
+int pipe_write(struct pipe *pipe, const void *base, size_t len);
+
+#endif /* !__KERN_FS_PIPE_H__ */
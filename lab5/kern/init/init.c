@@ -10,8 +10,15 @@
 #include <pmm.h>
 #include <vmm.h>
 #include <proc.h>
+#include <sched.h>
+#include <futex.h>
+#include <workqueue.h>
 #include <kmonitor.h>
 #include <dtb.h>
+#include <smp.h>
+#include <klog.h>
+#include <perf.h>
+#include <boot.h>
 
 int kern_init(void) __attribute__((noreturn));
 void grade_backtrace(void);
@@ -20,7 +27,14 @@ int kern_init(void)
 {
     extern char edata[], end[];
     memset(edata, 0, end - edata);
+    boot_phase("early");
+    smp_init(); // set up this hart's struct cpu
+    klog_init(); // init the kernel log
+    boot_phase("dtb");
     dtb_init();
+    boot_options_init(); // read the bootargs
+    boot_phase("console");
+    pic_init();  // init interrupt controller
     cons_init(); // init the console
 
     const char *message = "(THU.CST) os is loading ...";
@@ -30,15 +44,25 @@ int kern_init(void)
 
     // grade_backtrace();
 
+    boot_phase("pmm");
     pmm_init(); // init physical memory management
 
-    pic_init(); // init interrupt controller
     idt_init(); // init interrupt descriptor table
 
+    boot_phase("vmm");
     vmm_init();  // init virtual memory management
+    boot_phase("proc");
+    sched_init(); // init scheduler and kernel timers
+    futex_init(); // init futex wait table
+    workqueue_init(); // init system workqueue
     proc_init(); // init process table
 
+    boot_phase("clock");
     clock_init();  // init clock interrupt
+    perf_init();   // init performance counters
+    boot_phase("smp");
+    smp_boot();    // start the other harts
+    boot_phase("sched"); // until init_main runs
     intr_enable(); // enable irq interrupt
 
     cpu_idle(); // run idle process
@@ -1,18 +1,17 @@
 #include <defs.h>
 #include <stdio.h>
 #include <console.h>
+#include <string.h>
 
 /* HIGH level console I/O */
 
-/* *
- * cputch - writes a single character @c to stdout, and it will
- * increace the value of counter pointed by @cnt.
- * */
+#define CPRINTBUF_SIZE 128
+
+/* cons_sink - the printbuf sink of cprintf: whole runs go to the console at once */
 static void
-cputch(int c, int *cnt)
+cons_sink(void *data, const char *s, size_t len)
 {
-    cons_putc(c);
-    (*cnt)++;
+    cons_write(s, len);
 }
 
 /* *
@@ -26,9 +25,12 @@ cputch(int c, int *cnt)
  * */
 int vcprintf(const char *fmt, va_list ap)
 {
-    int cnt = 0;
-    vprintfmt((void *)cputch, &cnt, fmt, ap);
-    return cnt;
+    char buf[CPRINTBUF_SIZE];
+    struct printbuf pb;
+    printbuf_init(&pb, buf, sizeof(buf), cons_sink, NULL);
+    vprintbuf(&pb, fmt, ap);
+    printbuf_flush(&pb);
+    return pb.cnt;
 }
 
 /* *
@@ -59,14 +61,10 @@ void cputchar(int c)
  * */
 int cputs(const char *str)
 {
-    int cnt = 0;
-    char c;
-    while ((c = *str++) != '\0')
-    {
-        cputch(c, &cnt);
-    }
-    cputch('\n', &cnt);
-    return cnt;
+    size_t len = strlen(str);
+    cons_write(str, len);
+    cons_write("\n", 1);
+    return len + 1;
 }
 
 /* getchar - reads a single non-zero character from stdin */
@@ -74,6 +72,8 @@ int getchar(void)
 {
     int c;
     while ((c = cons_getc()) == 0)
-        /* do nothing */;
+    {
+        cons_wait_input();
+    }
     return c;
 }
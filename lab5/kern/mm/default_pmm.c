@@ -97,6 +97,7 @@ default_init_memmap(struct Page *base, size_t n)
             else if (list_next(le) == &free_list)
             {
                 list_add(le, &(base->page_link));
+                break;
             }
         }
     }
@@ -171,6 +172,7 @@ default_free_pages(struct Page *base, size_t n)
             else if (list_next(le) == &free_list)
             {
                 list_add(le, &(base->page_link));
+                break;
             }
         }
     }
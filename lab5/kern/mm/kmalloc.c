@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <kmalloc.h>
 #include <sync.h>
+#include <spinlock.h>
 #include <pmm.h>
 #include <stdio.h>
 
@@ -39,8 +40,6 @@
  */
 
 // some helper
-#define spin_lock_irqsave(l, f) local_intr_save(f)
-#define spin_unlock_irqrestore(l, f) local_intr_restore(f)
 typedef unsigned int gfp_t;
 #ifndef PAGE_SIZE
 #define PAGE_SIZE PGSIZE
@@ -76,6 +75,9 @@ typedef struct bigblock bigblock_t;
 static slob_t arena = {.next = &arena, .units = 1};
 static slob_t *slobfree = &arena;
 static bigblock_t *bigblocks;
+// slob_lock guards the free list, block_lock the list of big blocks
+static spinlock_t slob_lock = SPINLOCK_INIT("slob");
+static spinlock_t block_lock = SPINLOCK_INIT("bigblock");
 
 static void *__slob_get_free_pages(gfp_t gfp, int order)
 {
@@ -89,7 +91,7 @@ static void *__slob_get_free_pages(gfp_t gfp, int order)
 
 static inline void __slob_free_pages(unsigned long kva, int order)
 {
-	free_pages(kva2page(kva), 1 << order);
+	free_pages(kva2page((void *)kva), 1 << order);
 }
 
 static void slob_free(void *b, int size);
@@ -100,7 +102,7 @@ static void *slob_alloc(size_t size, gfp_t gfp, int align)
 
 	slob_t *prev, *cur, *aligned = 0;
 	int delta = 0, units = SLOB_UNITS(size);
-	unsigned long flags;
+	bool flags;
 
 	spin_lock_irqsave(&slob_lock, flags);
 	prev = slobfree;
@@ -158,7 +160,7 @@ static void *slob_alloc(size_t size, gfp_t gfp, int align)
 static void slob_free(void *block, int size)
 {
 	slob_t *cur, *b = (slob_t *)block;
-	unsigned long flags;
+	bool flags;
 
 	if (!block)
 		return;
@@ -217,10 +219,11 @@ kallocated(void)
 	return slob_allocated();
 }
 
+/* the smallest order whose pages hold size bytes */
 static int find_order(int size)
 {
 	int order = 0;
-	for (; size > 4096; size >>= 1)
+	while ((PAGE_SIZE << order) < size)
 		order++;
 	return order;
 }
@@ -229,9 +232,10 @@ static void *__kmalloc(size_t size, gfp_t gfp)
 {
 	slob_t *m;
 	bigblock_t *bb;
-	unsigned long flags;
+	bool flags;
 
-	if (size < PAGE_SIZE - SLOB_UNIT)
+	/* slob_alloc takes the header too and needs room for it below PAGE_SIZE */
+	if (size + SLOB_UNIT < PAGE_SIZE - SLOB_UNIT)
 	{
 		m = slob_alloc(size + SLOB_UNIT, gfp, 0);
 		return m ? (void *)(m + 1) : 0;
@@ -266,7 +270,7 @@ kmalloc(size_t size)
 void kfree(void *block)
 {
 	bigblock_t *bb, **last = &bigblocks;
-	unsigned long flags;
+	bool flags;
 
 	if (!block)
 		return;
@@ -296,7 +300,7 @@ void kfree(void *block)
 unsigned int ksize(const void *block)
 {
 	bigblock_t *bb;
-	unsigned long flags;
+	bool flags;
 
 	if (!block)
 		return 0;
@@ -307,7 +311,7 @@ unsigned int ksize(const void *block)
 		for (bb = bigblocks; bb; bb = bb->next)
 			if (bb->pages == block)
 			{
-				spin_unlock_irqrestore(&slob_lock, flags);
+				spin_unlock_irqrestore(&block_lock, flags);
 				return PAGE_SIZE << bb->order;
 			}
 		spin_unlock_irqrestore(&block_lock, flags);
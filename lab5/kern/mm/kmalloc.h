@@ -9,6 +9,7 @@ void kmalloc_init(void);
 
 void *kmalloc(size_t n);
 void kfree(void *objp);
+unsigned int ksize(const void *objp);
 
 size_t kallocated(void);
 
@@ -50,6 +50,14 @@
 #define KERNTOP (KERNBASE + KMEMSIZE)
 
 #define PHYSICAL_MEMORY_OFFSET 0xFFFFFFFF40000000
+
+/* *
+ * The first 1G of physical address space, where QEMU virt places its
+ * devices (CLINT, PLIC, UART, ...), is mapped here by a gigapage in the
+ * boot page table (see kern/init/entry.S). Kernel only, never executable.
+ * */
+#define KIOBASE 0xFFFFFFFF00000000
+#define KIOSIZE 0x40000000
 /* *
  * Virtual page table. Entry PDX[VPT] in the PD (Page Directory) contains
  * a pointer to the page directory itself, thereby turning the PD into a page
@@ -75,6 +83,9 @@
 #define KERN_ACCESS(start, end) \
     (KERNBASE <= (start) && (start) < (end) && (end) <= KERNTOP)
 
+/* IOADDR - the kernel virtual address of device register at physical @pa */
+#define IOADDR(pa) (KIOBASE + (uintptr_t)(pa))
+
 #ifndef __ASSEMBLER__
 
 #include <defs.h>
@@ -12,6 +12,10 @@
 #include <sync.h>
 #include <vmm.h>
 #include <riscv.h>
+#include <smp.h>
+#include <spinlock.h>
+#include <trace.h>
+#include <boot.h>
 
 // virtual address of physical page array
 struct Page *pages;
@@ -29,11 +33,82 @@ uintptr_t boot_pgdir_pa;
 
 // physical memory management
 const struct pmm_manager *pmm_manager;
+// serializes the calls into pmm_manager
+static spinlock_t pmm_lock = SPINLOCK_INIT("pmm");
 
 static void check_alloc_page(void);
 static void check_pgdir(void);
 static void check_boot_pgdir(void);
 
+/* *
+ * Whole-page clear and copy. clear_page uses the Zicboz cbo.zero
+ * instruction when the hart has it, which zeroes a cache block without
+ * reading it from memory first; otherwise, and for copy_page, unrolled
+ * word loads and stores, with none of memset/memcpy's alignment checks.
+ * The variant is picked once by page_ops_init.
+ * */
+static size_t cboz_size;
+static void (*clear_page_fn)(void *kva);
+
+static void
+clear_page_words(void *kva)
+{
+    unsigned long *p = kva, *end = p + PGSIZE / sizeof(unsigned long);
+    for (; p < end; p += 8)
+    {
+        p[0] = 0, p[1] = 0, p[2] = 0, p[3] = 0;
+        p[4] = 0, p[5] = 0, p[6] = 0, p[7] = 0;
+    }
+}
+
+static void
+clear_page_cboz(void *kva)
+{
+    uintptr_t p = (uintptr_t)kva, end = p + PGSIZE;
+    for (; p < end; p += cboz_size)
+    {
+        // cbo.zero (p), spelled out for assemblers without Zicboz
+        asm volatile(".insn i 0x0f, 2, x0, %0, 4" ::"r"(p) : "memory");
+    }
+}
+
+void clear_page(void *kva)
+{
+    assert(((uintptr_t)kva & (PGSIZE - 1)) == 0);
+    clear_page_fn(kva);
+}
+
+void copy_page(void *dst, const void *src)
+{
+    assert((((uintptr_t)dst | (uintptr_t)src) & (PGSIZE - 1)) == 0);
+    unsigned long *d = dst, *end = d + PGSIZE / sizeof(unsigned long);
+    const unsigned long *s = src;
+    for (; d < end; d += 8, s += 8)
+    {
+        unsigned long w0 = s[0], w1 = s[1], w2 = s[2], w3 = s[3];
+        unsigned long w4 = s[4], w5 = s[5], w6 = s[6], w7 = s[7];
+        d[0] = w0, d[1] = w1, d[2] = w2, d[3] = w3;
+        d[4] = w4, d[5] = w5, d[6] = w6, d[7] = w7;
+    }
+}
+
+// page_ops_init - pick the clear_page variant; dtb_init must have run
+static void page_ops_init(void)
+{
+    cboz_size = get_cboz_block_size();
+    // the block size must be a power of two dividing the page
+    if (dtb_has_isa_ext("zicboz") && cboz_size >= sizeof(unsigned long) &&
+        cboz_size <= PGSIZE && (cboz_size & (cboz_size - 1)) == 0)
+    {
+        clear_page_fn = clear_page_cboz;
+        cprintf("clear_page: zicboz, %d-byte blocks\n", (int)cboz_size);
+    }
+    else
+    {
+        clear_page_fn = clear_page_words;
+    }
+}
+
 // init_pmm_manager - initialize a pmm_manager instance
 static void init_pmm_manager(void)
 {
@@ -54,11 +129,12 @@ struct Page *alloc_pages(size_t n)
 {
     struct Page *page = NULL;
     bool intr_flag;
-    local_intr_save(intr_flag);
+    spin_lock_irqsave(&pmm_lock, intr_flag);
     {
         page = pmm_manager->alloc_pages(n);
     }
-    local_intr_restore(intr_flag);
+    spin_unlock_irqrestore(&pmm_lock, intr_flag);
+    trace(TRACE_ALLOC_PAGES, n, (page != NULL) ? page2pa(page) : 0);
     return page;
 }
 
@@ -66,11 +142,11 @@ struct Page *alloc_pages(size_t n)
 void free_pages(struct Page *base, size_t n)
 {
     bool intr_flag;
-    local_intr_save(intr_flag);
+    spin_lock_irqsave(&pmm_lock, intr_flag);
     {
         pmm_manager->free_pages(base, n);
     }
-    local_intr_restore(intr_flag);
+    spin_unlock_irqrestore(&pmm_lock, intr_flag);
 }
 
 // nr_free_pages - call pmm->nr_free_pages to get the size (nr*PAGESIZE)
@@ -79,11 +155,11 @@ size_t nr_free_pages(void)
 {
     size_t ret;
     bool intr_flag;
-    local_intr_save(intr_flag);
+    spin_lock_irqsave(&pmm_lock, intr_flag);
     {
         ret = pmm_manager->nr_free_pages();
     }
-    local_intr_restore(intr_flag);
+    spin_unlock_irqrestore(&pmm_lock, intr_flag);
     return ret;
 }
 
@@ -186,6 +262,7 @@ void pmm_init(void)
     // Then pmm can alloc/free the physical memory.
     // Now the first_fit/best_fit/worst_fit/buddy_system pmm are available.
     init_pmm_manager();
+    page_ops_init();
 
     // detect physical memory space, reserve already used memory,
     // then use pmm->init_memmap to create free page list
@@ -193,20 +270,25 @@ void pmm_init(void)
 
     // use pmm->check to verify the correctness of the alloc/free function in a
     // pmm
-    check_alloc_page();
+    if (boot_check(BOOT_CHECK_PMM))
+    {
+        check_alloc_page();
+    }
 
     // create boot_pgdir, an initial page directory(Page Directory Table, PDT)
     extern char boot_page_table_sv39[];
     boot_pgdir_va = (pte_t *)boot_page_table_sv39;
     boot_pgdir_pa = PADDR(boot_pgdir_va);
 
-    check_pgdir();
-
     static_assert(KERNBASE % PTSIZE == 0 && KERNTOP % PTSIZE == 0);
 
     // now the basic virtual memory map(see memalyout.h) is established.
     // check the correctness of the basic virtual memory map.
-    check_boot_pgdir();
+    if (boot_check(BOOT_CHECK_PGDIR))
+    {
+        check_pgdir();
+        check_boot_pgdir();
+    }
 
     kmalloc_init();
 }
@@ -230,7 +312,7 @@ pte_t *get_pte(pde_t *pgdir, uintptr_t la, bool create)
         }
         set_page_ref(page, 1);
         uintptr_t pa = page2pa(page);
-        memset(KADDR(pa), 0, PGSIZE);
+        clear_page(KADDR(pa));
         *pdep1 = pte_create(page2ppn(page), PTE_U | PTE_V);
     }
 
@@ -244,7 +326,7 @@ pte_t *get_pte(pde_t *pgdir, uintptr_t la, bool create)
         }
         set_page_ref(page, 1);
         uintptr_t pa = page2pa(page);
-        memset(KADDR(pa), 0, PGSIZE);
+        clear_page(KADDR(pa));
         *pdep0 = pte_create(page2ppn(page), PTE_U | PTE_V);
     }
     return &((pte_t *)KADDR(PDE_ADDR(*pdep0)))[PTX(la)];
@@ -301,6 +383,7 @@ void unmap_range(pde_t *pgdir, uintptr_t start, uintptr_t end)
             page_remove_pte(pgdir, start, ptep);
         }
         start += PGSIZE;
+        cond_resched();
     } while (start != 0 && start < end);
 }
 
@@ -415,7 +498,7 @@ int copy_range(pde_t *to, pde_t *from, uintptr_t start, uintptr_t end,
              * memory which page managed (SEE pmm.h)
              *    page_insert: build the map of phy addr of an Page with the
              * linear addr la
-             *    memcpy: typical memory copy function
+             *    copy_page: copy a whole page
              *
              * (1) find src_kvaddr: the kernel virtual address of page
              * (2) find dst_kvaddr: the kernel virtual address of npage
@@ -426,13 +509,14 @@ int copy_range(pde_t *to, pde_t *from, uintptr_t start, uintptr_t end,
             assert(ret == 0);
             void *src_kvaddr = page2kva(page); // (1) Source kernel virtual address
             void *dst_kvaddr = page2kva(npage); // (2) Destination kernel virtual address
-            memcpy(dst_kvaddr, src_kvaddr, PGSIZE); // (3) Copy memory
+            copy_page(dst_kvaddr, src_kvaddr); // (3) Copy memory
             ret = page_insert(to, npage, start, perm); // (4) Map physical address of npage to linear address start
             if (ret != 0) {
                 return ret;
             }
         }
         start += PGSIZE;
+        cond_resched();
     } while (start != 0 && start < end);
     return 0;
 }
@@ -481,11 +565,15 @@ int page_insert(pde_t *pgdir, struct Page *page, uintptr_t la, uint32_t perm)
     return 0;
 }
 
-// invalidate a TLB entry, but only if the page tables being
-// edited are the ones currently in use by the processor.
+// invalidate a TLB entry, here and on the other harts that run on the
+// page tables being edited.
 void tlb_invalidate(pde_t *pgdir, uintptr_t la)
 {
     asm volatile("sfence.vma %0" : : "r"(la));
+    if (ncpu > 1)
+    {
+        smp_tlb_invalidate(PADDR(pgdir), la);
+    }
 }
 
 // pgdir_alloc_page - call alloc_page & page_insert functions to
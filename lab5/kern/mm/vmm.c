@@ -7,6 +7,8 @@
 #include <pmm.h>
 #include <riscv.h>
 #include <kmalloc.h>
+#include <clock.h>
+#include <boot.h>
 
 /*
   vmm design include two parts: mm_struct (mm) & vma_struct (vma)
@@ -37,6 +39,9 @@
 static void check_vmm(void);
 static void check_vma_struct(void);
 
+// the mmap_sem statistics of every mm destroyed so far
+static struct rwsem_stat mm_lock_stat;
+
 // mm_create -  alloc a mm_struct & initialize it.
 struct mm_struct *
 mm_create(void)
@@ -53,7 +58,7 @@ mm_create(void)
         mm->sm_priv = NULL;
 
         set_mm_count(mm, 0);
-        lock_init(&(mm->mm_lock));
+        init_rwsem(&(mm->mmap_sem));
     }
     return mm;
 }
@@ -157,6 +162,17 @@ void mm_destroy(struct mm_struct *mm)
 {
     assert(mm_count(mm) == 0);
 
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        mm_lock_stat.nr_read += mm->mmap_sem.stat.nr_read;
+        mm_lock_stat.nr_write += mm->mmap_sem.stat.nr_write;
+        mm_lock_stat.nr_read_wait += mm->mmap_sem.stat.nr_read_wait;
+        mm_lock_stat.nr_write_wait += mm->mmap_sem.stat.nr_write_wait;
+        mm_lock_stat.wait_cycles += mm->mmap_sem.stat.wait_cycles;
+    }
+    local_intr_restore(intr_flag);
+
     list_entry_t *list = &(mm->mmap_list), *le;
     while ((le = list_next(list)) != list)
     {
@@ -167,6 +183,16 @@ void mm_destroy(struct mm_struct *mm)
     mm = NULL;
 }
 
+// print_mm_lock_stats - how often mmap_sem was taken and contended, over the address spaces torn down so far
+void print_mm_lock_stats(void)
+{
+    cprintf("mmap_sem of the mms destroyed so far (live ones not included):\n");
+    cprintf("  %ld reads (%ld waited), %ld writes (%ld waited), %ld us asleep\n",
+            (long)mm_lock_stat.nr_read, (long)mm_lock_stat.nr_read_wait,
+            (long)mm_lock_stat.nr_write, (long)mm_lock_stat.nr_write_wait,
+            (long)clock_cycles_to_usec(mm_lock_stat.wait_cycles));
+}
+
 int mm_map(struct mm_struct *mm, uintptr_t addr, size_t len, uint32_t vm_flags,
            struct vma_struct **vma_store)
 {
@@ -265,10 +291,13 @@ bool copy_to_user(struct mm_struct *mm, void *dst, const void *src, size_t len)
 }
 
 // vmm_init - initialize virtual memory management
-//          - now just call check_vmm to check correctness of vmm
+//          - now just call check_vmm to check correctness of vmm, unless the bootargs turned it off
 void vmm_init(void)
 {
-    check_vmm();
+    if (boot_check(BOOT_CHECK_VMM))
+    {
+        check_vmm();
+    }
 }
 
 // check_vmm - check correctness of vmm
@@ -5,6 +5,7 @@
 #include <list.h>
 #include <memlayout.h>
 #include <sync.h>
+#include <rwsem.h>
 
 // pre define
 struct mm_struct;
@@ -37,7 +38,7 @@ struct mm_struct
     int map_count;                 // the count of these vma
     void *sm_priv;                 // the private data for swap manager
     int mm_count;                  // the number ofprocess which shared the mm
-    lock_t mm_lock;                // mutex for using dup_mmap fun to duplicat the mm
+    rw_semaphore_t mmap_sem;       // read-held to look at the vmas and page tables, write-held to change them
 };
 
 struct vma_struct *find_vma(struct mm_struct *mm, uintptr_t addr);
@@ -75,26 +76,49 @@ set_mm_count(struct mm_struct *mm, int val)
     mm->mm_count = val;
 }
 
+// the count is shared by threads that may be preempted, update it atomically
 static inline int
 mm_count_inc(struct mm_struct *mm)
 {
-    mm->mm_count += 1;
-    return mm->mm_count;
+    bool intr_flag;
+    int count;
+    local_intr_save(intr_flag);
+    count = (mm->mm_count += 1);
+    local_intr_restore(intr_flag);
+    return count;
 }
 
 static inline int
 mm_count_dec(struct mm_struct *mm)
 {
-    mm->mm_count -= 1;
-    return mm->mm_count;
+    bool intr_flag;
+    int count;
+    local_intr_save(intr_flag);
+    count = (mm->mm_count -= 1);
+    local_intr_restore(intr_flag);
+    return count;
 }
 
+/* *
+ * lock_mm - take mm->mmap_sem for writing, around changes to the vma list
+ * and page tables. Taken by load_icode while it builds a new mm and by
+ * mm_release (the last user's do_exit, and do_execve) while it tears one
+ * down. lab5 has no page fault handler and no mmap/munmap/brk system call
+ * (mm_unmap and mm_brk are only declared), so nothing yet changes a mm
+ * while other threads are using it.
+ *
+ * mmap_read_lock is taken by copy_mm around dup_mmap and around the
+ * user_mem_check/copy_{from,to}_user calls of do_execve, do_wait_timeout,
+ * sys_puts, sysfile_pipe, pipe_read, pipe_write and do_perf_read, which
+ * several threads of a process may run at the same time. Both accept a NULL mm (kernel threads)
+ * and do nothing.
+ * */
 static inline void
 lock_mm(struct mm_struct *mm)
 {
     if (mm != NULL)
     {
-        lock(&(mm->mm_lock));
+        down_write(&(mm->mmap_sem));
     }
 }
 
@@ -103,8 +127,28 @@ unlock_mm(struct mm_struct *mm)
 {
     if (mm != NULL)
     {
-        unlock(&(mm->mm_lock));
+        up_write(&(mm->mmap_sem));
+    }
+}
+
+static inline void
+mmap_read_lock(struct mm_struct *mm)
+{
+    if (mm != NULL)
+    {
+        down_read(&(mm->mmap_sem));
     }
 }
 
+static inline void
+mmap_read_unlock(struct mm_struct *mm)
+{
+    if (mm != NULL)
+    {
+        up_read(&(mm->mmap_sem));
+    }
+}
+
+void print_mm_lock_stats(void);
+
 #endif /* !__KERN_MM_VMM_H__ */
@@ -0,0 +1,221 @@
+#include <defs.h>
+#include <string.h>
+#include <unistd.h>
+#include <error.h>
+#include <sync.h>
+#include <wait.h>
+#include <proc.h>
+#include <sched.h>
+#include <assert.h>
+#include <ipc.h>
+
+/* *
+ * Synchronous rendezvous IPC, in the style of L4. A client sends
+ * IPC_MSG_WORDS words to a server with SYS_call and sleeps until the
+ * server answers; a server answers its last client and waits for the next
+ * one in a single SYS_reply_wait. Messages travel in registers: the words
+ * are copied from the sender's syscall arguments into the receiver's
+ * ipc_msg and from there into its a1..a4 when its syscall returns.
+ *
+ * When the other side is already waiting, the kernel switches to it with
+ * schedule_handoff() instead of going through schedule(), so a round trip costs
+ * one context switch each way. A client that finds the server busy queues
+ * on server->ipc_senders and is picked up by its next reply_wait.
+ *
+ * While a call is in progress client->ipc_partner is the server and
+ * server->ipc_partner the client. Whoever ends the rendezvous (the reply,
+ * the exit of the server, or the client giving up after a kill) clears
+ * both, so neither side keeps a pointer to a process that may be freed.
+ * */
+
+// ipc_deliver - return the message in current->ipc_msg to user space in a1..a4
+static void
+ipc_deliver(void)
+{
+    struct trapframe *tf = current->tf;
+    tf->gpr.a1 = current->ipc_msg[0];
+    tf->gpr.a2 = current->ipc_msg[1];
+    tf->gpr.a3 = current->ipc_msg[2];
+    tf->gpr.a4 = current->ipc_msg[3];
+}
+
+// ipc_is_client - is @client in a call to current that current has received?
+static bool
+ipc_is_client(struct proc_struct *client)
+{
+    return client != NULL && client->ipc_partner == current && current->ipc_partner == client;
+}
+
+// ipc_end - end the rendezvous with current's client, which sees @status
+static void
+ipc_end(struct proc_struct *client, int status)
+{
+    client->ipc_partner = NULL;
+    client->ipc_status = status;
+    current->ipc_partner = NULL;
+    // it may have been woken up by do_kill already
+    if (client->state == PROC_SLEEPING)
+    {
+        wakeup_proc(client);
+    }
+}
+
+/* *
+ * do_ipc_call - send @msg to process @pid and wait for its reply, which
+ * replaces the caller's a1..a4. Interrupts stay disabled from the check of
+ * the server's state until the switch, so the handoff cannot be raced.
+ * */
+int do_ipc_call(int pid, const uint64_t *msg)
+{
+    struct proc_struct *server;
+    bool intr_flag;
+    int ret;
+    local_intr_save(intr_flag);
+    proc_table_lock();
+    if ((server = find_proc(pid)) == NULL || server == current || server->mm == NULL ||
+        server->state == PROC_ZOMBIE || (server->flags & PF_EXITING))
+    {
+        proc_table_unlock();
+        local_intr_restore(intr_flag);
+        return -E_BAD_PROC;
+    }
+    // from here on the server's exit clears ipc_partner before it is freed
+    current->ipc_partner = server;
+    proc_table_unlock();
+    current->ipc_status = -E_BAD_PROC;
+    if (server->state == PROC_SLEEPING && server->wait_state == WT_IPC_RECV)
+    {
+        // the server is waiting for us: hand the message over and run it now
+        memcpy(server->ipc_msg, msg, sizeof(server->ipc_msg));
+        server->ipc_partner = current;
+        wakeup_proc(server);
+        current->state = PROC_SLEEPING;
+        current->wait_state = WT_IPC_REPLY;
+        schedule_handoff(server);
+    }
+    else
+    {
+        // the server is busy, its next reply_wait takes the message from us
+        memcpy(current->ipc_msg, msg, sizeof(current->ipc_msg));
+        wait_t __wait, *wait = &__wait;
+        wait_current_set(&(server->ipc_senders), wait, WT_IPC_SEND);
+        local_intr_restore(intr_flag);
+
+        schedule();
+
+        local_intr_save(intr_flag);
+        wait_current_del(&(server->ipc_senders), wait);
+    }
+
+    if (current->ipc_partner != NULL)
+    {
+        // woken up by do_kill before the server replied
+        if (server->ipc_partner == current)
+        {
+            server->ipc_partner = NULL;
+        }
+        current->ipc_partner = NULL;
+        ret = -E_KILLED;
+    }
+    else if ((ret = current->ipc_status) == 0)
+    {
+        ipc_deliver();
+    }
+    local_intr_restore(intr_flag);
+    return ret;
+}
+
+/* *
+ * do_ipc_reply_wait - if @pid is not 0, send @msg as the reply to the
+ * client @pid, then wait for the next call. Returns the pid of the caller,
+ * whose message replaces a1..a4; the caller is owed a reply by the next
+ * reply_wait. A pending client that is not replied to fails with
+ * -E_BAD_PROC.
+ * */
+int do_ipc_reply_wait(int pid, const uint64_t *msg)
+{
+    struct proc_struct *client = NULL, *sender;
+    bool intr_flag;
+    int ret;
+    local_intr_save(intr_flag);
+    if (pid != 0)
+    {
+        proc_table_lock();
+        if (!ipc_is_client(client = find_proc(pid)))
+        {
+            proc_table_unlock();
+            local_intr_restore(intr_flag);
+            return -E_BAD_PROC;
+        }
+        memcpy(client->ipc_msg, msg, sizeof(client->ipc_msg));
+        ipc_end(client, 0);
+        proc_table_unlock();
+    }
+    else if (ipc_is_client(current->ipc_partner))
+    {
+        ipc_end(current->ipc_partner, -E_BAD_PROC);
+    }
+    current->ipc_partner = NULL;
+
+    wait_t *wait;
+    if ((wait = wait_queue_first(&(current->ipc_senders))) != NULL)
+    {
+        // a client is queued: take its message, it keeps sleeping until our reply
+        sender = wait->proc;
+        wait_queue_del(&(current->ipc_senders), wait);
+        memcpy(current->ipc_msg, sender->ipc_msg, sizeof(current->ipc_msg));
+        sender->wait_state = WT_IPC_REPLY;
+        current->ipc_partner = sender;
+    }
+    else
+    {
+        current->state = PROC_SLEEPING;
+        current->wait_state = WT_IPC_RECV;
+        if (client != NULL)
+        {
+            schedule_handoff(client);
+        }
+        else
+        {
+            local_intr_restore(intr_flag);
+            schedule();
+            local_intr_save(intr_flag);
+        }
+    }
+
+    if ((sender = current->ipc_partner) == NULL)
+    {
+        // woken up by do_kill
+        ret = -E_KILLED;
+    }
+    else
+    {
+        ret = sender->pid;
+        ipc_deliver();
+    }
+    local_intr_restore(intr_flag);
+    return ret;
+}
+
+// ipc_exit - fail the calls that wait for @proc, which is exiting
+void ipc_exit(struct proc_struct *proc)
+{
+    assert(proc == current);
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        if (ipc_is_client(proc->ipc_partner))
+        {
+            ipc_end(proc->ipc_partner, -E_BAD_PROC);
+        }
+        proc->ipc_partner = NULL;
+        wait_t *wait;
+        while ((wait = wait_queue_first(&(proc->ipc_senders))) != NULL)
+        {
+            wait->proc->ipc_partner = NULL;
+            wait->proc->ipc_status = -E_BAD_PROC;
+            wakeup_wait(&(proc->ipc_senders), wait, WT_IPC_SEND, 1);
+        }
+    }
+    local_intr_restore(intr_flag);
+}
@@ -0,0 +1,12 @@
+#ifndef __KERN_PROCESS_IPC_H__
+#define __KERN_PROCESS_IPC_H__
+
+#include <defs.h>
+
+struct proc_struct;
+
+int do_ipc_call(int pid, const uint64_t *msg);
+int do_ipc_reply_wait(int pid, const uint64_t *msg);
+void ipc_exit(struct proc_struct *proc);
+
+#endif /* !__KERN_PROCESS_IPC_H__ */
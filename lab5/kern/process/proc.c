@@ -12,6 +12,15 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <unistd.h>
+#include <clock.h>
+#include <workqueue.h>
+#include <file.h>
+#include <ipc.h>
+#include <spinlock.h>
+#include <klog.h>
+#include <trace.h>
+#include <perf.h>
+#include <boot.h>
 
 /* ------------- process/thread mechanism design&implementation -------------
 (an simplified Linux process/thread mechanism )
@@ -69,14 +78,12 @@ list_entry_t proc_list;
 // has list for process set based on pid
 static list_entry_t hash_list[HASH_LIST_SIZE];
 
-// idle proc
-struct proc_struct *idleproc = NULL;
 // init proc
 struct proc_struct *initproc = NULL;
-// current proc
-struct proc_struct *current = NULL;
 
 static int nr_process = 0;
+// guards proc_list, hash_list, nr_process, pid allocation and the family links
+static spinlock_t proc_lock = SPINLOCK_INIT("proc");
 
 void kernel_thread_entry(void);
 void forkrets(struct trapframe *tf);
@@ -127,6 +134,17 @@ alloc_proc(void)
         memset(proc->name, 0, PROC_NAME_LEN + 1);
         proc->wait_state = 0;
         proc->cptr = proc->yptr = proc->optr = NULL;
+        wait_queue_init(&(proc->child_wait));
+        proc->preempt_count = 0;
+        proc->filesp = NULL;
+        proc->ipc_partner = NULL;
+        wait_queue_init(&(proc->ipc_senders));
+        memset(proc->ipc_msg, 0, sizeof(proc->ipc_msg));
+        proc->ipc_status = 0;
+        list_init(&(proc->run_link));
+        proc->rq = NULL;
+        proc->cpu = mycpu()->id;
+        proc->perf = NULL;
     }
     return proc;
 }
@@ -242,15 +260,21 @@ void proc_run(struct proc_struct *proc)
          */
         bool intr_flag;
         struct proc_struct *prev = current;
+        trace(TRACE_SWITCH, prev->pid, proc->pid);
         
         // 1. 禁用中断
         local_intr_save(intr_flag);
+
+        // 把性能计数记到换下的进程名下
+        perf_switch(prev, proc);
         
         // 2. 更新当前进程
         current = proc;
         
         // 3. 切换页表到新进程的地址空间
         lsatp(proc->pgdir);
+        // 其他 hart 只为正在使用该页表的 hart 刷新 TLB（见 smp_tlb_invalidate），这里要清掉旧表项
+        asm volatile("sfence.vma");
         
         // 4. 执行上下文切换
         switch_to(&(prev->context), &(proc->context));
@@ -266,6 +290,11 @@ void proc_run(struct proc_struct *proc)
 static void
 forkret(void)
 {
+    if (!trap_in_kernel(current->tf))
+    {
+        // about to enter user mode for the first time, like trap() does on return
+        kernel_unlock();
+    }
     forkrets(current->tf);
 }
 
@@ -283,10 +312,29 @@ unhash_proc(struct proc_struct *proc)
     list_del(&(proc->hash_link));
 }
 
-// find_proc - find proc frome proc hash_list according to pid
+/* *
+ * proc_table_lock/proc_table_unlock - take and drop proc_lock from outside
+ * this file, with interrupts already disabled.
+ * */
+void proc_table_lock(void)
+{
+    spin_lock(&proc_lock);
+}
+
+void proc_table_unlock(void)
+{
+    spin_unlock(&proc_lock);
+}
+
+/* *
+ * find_proc - find proc frome proc hash_list according to pid. The caller
+ * holds proc_lock from the lookup until done with the result, or the
+ * process may be reaped and freed meanwhile.
+ * */
 struct proc_struct *
 find_proc(int pid)
 {
+    assert(spin_holding(&proc_lock));
     if (0 < pid && pid < MAX_PID)
     {
         list_entry_t *list = hash_list + pid_hashfn(pid), *le = list;
@@ -316,6 +364,34 @@ int kernel_thread(int (*fn)(void *), void *arg, uint32_t clone_flags)
     return do_fork(clone_flags | CLONE_VM, 0, &tf);
 }
 
+/* *
+ * kthread_create - start a kernel thread that belongs to initproc rather
+ * than to current, so that no user process ends up waiting for it. Such
+ * threads must exit by themselves; initproc reaps them.
+ * */
+int kthread_create(int (*fn)(void *), void *arg, const char *name)
+{
+    int pid = kernel_thread(fn, arg, CLONE_KTHREAD);
+    if (pid > 0)
+    {
+        struct proc_struct *proc;
+        bool intr_flag;
+        spin_lock_irqsave(&proc_lock, intr_flag);
+        if ((proc = find_proc(pid)) != NULL)
+        {
+            if (initproc != NULL && proc->parent != initproc)
+            {
+                remove_links(proc);
+                proc->parent = initproc;
+                set_links(proc);
+            }
+            set_proc_name(proc, name);
+        }
+        spin_unlock_irqrestore(&proc_lock, intr_flag);
+    }
+    return pid;
+}
+
 // setup_kstack - alloc pages with size KSTACKPAGE as process kernel stack
 static int
 setup_kstack(struct proc_struct *proc)
@@ -346,7 +422,7 @@ setup_pgdir(struct mm_struct *mm)
         return -E_NO_MEM;
     }
     pde_t *pgdir = page2kva(page);
-    memcpy(pgdir, boot_pgdir_va, PGSIZE);
+    copy_page(pgdir, boot_pgdir_va);
 
     mm->pgdir = pgdir;
     return 0;
@@ -366,8 +442,8 @@ copy_mm(uint32_t clone_flags, struct proc_struct *proc)
 {
     struct mm_struct *mm, *oldmm = current->mm;
 
-    /* current is a kernel thread */
-    if (oldmm == NULL)
+    /* current is a kernel thread, or the child is one made by kthread_create */
+    if (oldmm == NULL || (clone_flags & CLONE_KTHREAD))
     {
         return 0;
     }
@@ -385,11 +461,12 @@ copy_mm(uint32_t clone_flags, struct proc_struct *proc)
     {
         goto bad_pgdir_cleanup_mm;
     }
-    lock_mm(oldmm);
+    // dup_mmap only reads oldmm
+    mmap_read_lock(oldmm);
     {
         ret = dup_mmap(mm, oldmm);
     }
-    unlock_mm(oldmm);
+    mmap_read_unlock(oldmm);
 
     if (ret != 0)
     {
@@ -410,6 +487,49 @@ bad_mm:
     return ret;
 }
 
+// copy_files - give "proc" a copy of current's descriptor table, or share it if clone_flags & CLONE_FS
+static int
+copy_files(uint32_t clone_flags, struct proc_struct *proc, struct trapframe *tf)
+{
+    struct files_struct *filesp, *old_filesp = current->filesp;
+
+    /* current is a kernel thread, or the child will be one */
+    if (old_filesp == NULL || trap_in_kernel(tf) || (clone_flags & CLONE_KTHREAD))
+    {
+        return 0;
+    }
+    if (clone_flags & CLONE_FS)
+    {
+        filesp = old_filesp;
+        goto good_files;
+    }
+    if ((filesp = files_create()) == NULL)
+    {
+        return -E_NO_MEM;
+    }
+    dup_files(filesp, old_filesp);
+
+good_files:
+    files_count_inc(filesp);
+    proc->filesp = filesp;
+    return 0;
+}
+
+// put_files - drop proc's reference to its descriptor table, closing the files with the last one
+static void
+put_files(struct proc_struct *proc)
+{
+    struct files_struct *filesp = proc->filesp;
+    if (filesp != NULL)
+    {
+        proc->filesp = NULL;
+        if (files_count_dec(filesp) == 0)
+        {
+            files_destroy(filesp);
+        }
+    }
+}
+
 // copy_thread - setup the trapframe on the  process's kernel stack top and
 //             - setup the kernel entry point and stack of process
 static void
@@ -484,15 +604,20 @@ int do_fork(uint32_t clone_flags, uintptr_t stack, struct trapframe *tf)
         goto bad_fork_cleanup_proc;
     }
 
-    if (copy_mm(clone_flags, proc) != 0)
+    if (copy_files(clone_flags, proc, tf) != 0)
     {
         goto bad_fork_cleanup_kstack;
     }
 
+    if (copy_mm(clone_flags, proc) != 0)
+    {
+        goto bad_fork_cleanup_fs;
+    }
+
     copy_thread(proc, stack, tf);
 
     bool intr_flag;
-    local_intr_save(intr_flag);
+    spin_lock_irqsave(&proc_lock, intr_flag);
     {
         proc->pid = get_pid();
         hash_proc(proc);
@@ -502,15 +627,18 @@ int do_fork(uint32_t clone_flags, uintptr_t stack, struct trapframe *tf)
         current->wait_state = 0;
         set_links(proc);
     }
-    local_intr_restore(intr_flag);
+    spin_unlock_irqrestore(&proc_lock, intr_flag);
 
     wakeup_proc(proc);
 
     ret = proc->pid;
 
 fork_out:
+    trace(TRACE_FORK, ret, clone_flags);
     return ret;
 
+bad_fork_cleanup_fs:
+    put_files(proc);
 bad_fork_cleanup_kstack:
     put_kstack(proc);
 bad_fork_cleanup_proc:
@@ -518,12 +646,54 @@ bad_fork_cleanup_proc:
     goto fork_out;
 }
 
+// mm_release - tear down a mm nobody uses any more, under its write lock up to mm_destroy
+static void
+mm_release(struct mm_struct *mm)
+{
+    lock_mm(mm);
+    exit_mmap(mm);
+    put_pgdir(mm);
+    unlock_mm(mm);
+    mm_destroy(mm);
+}
+
+struct mm_release_work
+{
+    struct work_struct work;
+    struct mm_struct *mm;
+};
+
+static void
+mm_release_work_fn(struct work_struct *work)
+{
+    struct mm_release_work *mrw = to_struct(work, struct mm_release_work, work);
+    mm_release(mrw->mm);
+    kfree(mrw);
+}
+
+// mm_release_deferred - tear down an unused mm on system_wq, or right here if that fails
+static void
+mm_release_deferred(struct mm_struct *mm)
+{
+    struct mm_release_work *mrw;
+    if ((mrw = kmalloc(sizeof(struct mm_release_work))) != NULL)
+    {
+        INIT_WORK(&(mrw->work), mm_release_work_fn);
+        mrw->mm = mm;
+        queue_work(system_wq, &(mrw->work));
+        return;
+    }
+    mm_release(mm);
+}
+
 // do_exit - called by sys_exit
-//   1. call exit_mmap & put_pgdir & mm_destroy to free the almost all memory space of process
+//   0. fail pending IPC calls, close the process' files
+//   1. hand the memory space to mm_release_deferred, which frees it on system_wq
 //   2. set process' state as PROC_ZOMBIE, then call wakeup_proc(parent) to ask parent reclaim itself.
 //   3. call scheduler to switch to other process
 int do_exit(int error_code)
 {
+    trace(TRACE_EXIT, error_code, 0);
     if (current == idleproc)
     {
         panic("idleproc exit.\n");
@@ -532,29 +702,32 @@ int do_exit(int error_code)
     {
         panic("initproc exit.\n");
     }
+    // fail the IPC calls waiting for us
+    ipc_exit(current);
+    // close our ends of any pipes first, so that readers see end-of-file
+    put_files(current);
+    perf_release(current);
     struct mm_struct *mm = current->mm;
     if (mm != NULL)
     {
         lsatp(boot_pgdir_pa);
+        // we may be preempted while tearing the mm down, don't come back to it
+        current->pgdir = boot_pgdir_pa;
+        // nor hand it to a worker that queue_work forks from here
+        current->mm = NULL;
         if (mm_count_dec(mm) == 0)
         {
-            exit_mmap(mm);
-            put_pgdir(mm);
-            mm_destroy(mm);
+            mm_release_deferred(mm);
         }
-        current->mm = NULL;
     }
     current->state = PROC_ZOMBIE;
     current->exit_code = error_code;
     bool intr_flag;
     struct proc_struct *proc;
-    local_intr_save(intr_flag);
+    spin_lock_irqsave(&proc_lock, intr_flag);
     {
         proc = current->parent;
-        if (proc->wait_state == WT_CHILD)
-        {
-            wakeup_proc(proc);
-        }
+        wakeup_queue(&(proc->child_wait), WT_CHILD, 1);
         while (current->cptr != NULL)
         {
             proc = current->cptr;
@@ -569,14 +742,11 @@ int do_exit(int error_code)
             initproc->cptr = proc;
             if (proc->state == PROC_ZOMBIE)
             {
-                if (initproc->wait_state == WT_CHILD)
-                {
-                    wakeup_proc(initproc);
-                }
+                wakeup_queue(&(initproc->child_wait), WT_CHILD, 1);
             }
         }
     }
-    local_intr_restore(intr_flag);
+    spin_unlock_irqrestore(&proc_lock, intr_flag);
     schedule();
     panic("do_exit will not return!! %d.\n", current->pid);
 }
@@ -605,6 +775,8 @@ load_icode(unsigned char *binary, size_t size)
     {
         goto bad_pgdir_cleanup_mm;
     }
+    // nobody else can see mm yet, but its vmas and page tables change only under the write lock
+    lock_mm(mm);
     //(3) copy TEXT/DATA section, build BSS parts in binary to memory space of process
     struct Page *page;
     //(3.1) get the file header of the bianry program (ELF format)
@@ -677,6 +849,7 @@ load_icode(unsigned char *binary, size_t size)
             }
             memcpy(page2kva(page) + off, from, size);
             start += size, from += size;
+            cond_resched();
         }
 
         //(3.6.2) build BSS section of binary program
@@ -708,8 +881,16 @@ load_icode(unsigned char *binary, size_t size)
             {
                 size -= la - end;
             }
-            memset(page2kva(page) + off, 0, size);
+            if (size == PGSIZE)
+            {
+                clear_page(page2kva(page));
+            }
+            else
+            {
+                memset(page2kva(page) + off, 0, size);
+            }
             start += size;
+            cond_resched();
         }
     }
     //(4) build user stack memory
@@ -722,6 +903,7 @@ load_icode(unsigned char *binary, size_t size)
     assert(pgdir_alloc_page(mm->pgdir, USTACKTOP - 2 * PGSIZE, PTE_USER) != NULL);
     assert(pgdir_alloc_page(mm->pgdir, USTACKTOP - 3 * PGSIZE, PTE_USER) != NULL);
     assert(pgdir_alloc_page(mm->pgdir, USTACKTOP - 4 * PGSIZE, PTE_USER) != NULL);
+    unlock_mm(mm);
 
     //(5) set current process's mm, sr3, and set satp reg = physical addr of Page Directory
     mm_count_inc(mm);
@@ -753,6 +935,7 @@ out:
 bad_cleanup_mmap:
     exit_mmap(mm);
 bad_elf_cleanup_pgdir:
+    unlock_mm(mm);
     put_pgdir(mm);
 bad_pgdir_cleanup_mm:
     mm_destroy(mm);
@@ -765,7 +948,11 @@ bad_mm:
 int do_execve(const char *name, size_t len, unsigned char *binary, size_t size)
 {
     struct mm_struct *mm = current->mm;
-    if (!user_mem_check(mm, (uintptr_t)name, len, 0))
+    bool ok;
+    mmap_read_lock(mm);
+    ok = user_mem_check(mm, (uintptr_t)name, len, 0);
+    mmap_read_unlock(mm);
+    if (!ok)
     {
         return -E_INVAL;
     }
@@ -778,17 +965,29 @@ int do_execve(const char *name, size_t len, unsigned char *binary, size_t size)
     memset(local_name, 0, sizeof(local_name));
     memcpy(local_name, name, len);
 
+    if (current->filesp == NULL)
+    {
+        // a kernel thread turning into a user process, give it an empty descriptor table
+        struct files_struct *filesp;
+        if ((filesp = files_create()) == NULL)
+        {
+            return -E_NO_MEM;
+        }
+        files_count_inc(filesp);
+        current->filesp = filesp;
+    }
+
     if (mm != NULL)
     {
-        cputs("mm != NULL");
+        klog(KLOG_DEBUG, "mm != NULL\n");
         lsatp(boot_pgdir_pa);
+        // we may be preempted while tearing the mm down, don't come back to it
+        current->pgdir = boot_pgdir_pa;
+        current->mm = NULL;
         if (mm_count_dec(mm) == 0)
         {
-            exit_mmap(mm);
-            put_pgdir(mm);
-            mm_destroy(mm);
+            mm_release(mm);
         }
-        current->mm = NULL;
     }
     int ret;
     if ((ret = load_icode(binary, size)) != 0)
@@ -796,9 +995,11 @@ int do_execve(const char *name, size_t len, unsigned char *binary, size_t size)
         goto execve_exit;
     }
     set_proc_name(current, local_name);
+    trace(TRACE_EXEC, 0, 0);
     return 0;
 
 execve_exit:
+    trace(TRACE_EXEC, ret, 0);
     do_exit(ret);
     panic("already exit: %e.\n", ret);
 }
@@ -810,15 +1011,50 @@ int do_yield(void)
     return 0;
 }
 
+// do_sleep - put current process to sleep for @time ticks
+int do_sleep(unsigned int time)
+{
+    if (time == 0)
+    {
+        return 0;
+    }
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    timer_t __timer, *timer = timer_init(&__timer, current, time);
+    current->state = PROC_SLEEPING;
+    current->wait_state = WT_TIMER;
+    add_timer(timer);
+    local_intr_restore(intr_flag);
+
+    schedule();
+
+    del_timer(timer);
+    if (current->flags & PF_EXITING)
+    {
+        do_exit(-E_KILLED);
+    }
+    return 0;
+}
+
 // do_wait - wait one OR any children with PROC_ZOMBIE state, and free memory space of kernel stack
 //         - proc struct of this child.
 // NOTE: only after do_wait function, all resources of the child proces are free.
 int do_wait(int pid, int *code_store)
+{
+    return do_wait_timeout(pid, code_store, 0);
+}
+
+// do_wait_timeout - like do_wait, but give up with -E_TIMEOUT if no child exits within @timeout ticks (0 means no limit)
+int do_wait_timeout(int pid, int *code_store, size_t timeout)
 {
     struct mm_struct *mm = current->mm;
     if (code_store != NULL)
     {
-        if (!user_mem_check(mm, (uintptr_t)code_store, sizeof(int), 1))
+        bool ok;
+        mmap_read_lock(mm);
+        ok = user_mem_check(mm, (uintptr_t)code_store, sizeof(int), 1);
+        mmap_read_unlock(mm);
+        if (!ok)
         {
             return -E_INVAL;
         }
@@ -826,12 +1062,26 @@ int do_wait(int pid, int *code_store)
 
     struct proc_struct *proc;
     bool intr_flag, haskid;
+    timer_t __timer, *timer = NULL;
+    if (timeout != 0)
+    {
+        timer = timer_init(&__timer, current, timeout);
+        add_timer(timer);
+    }
 repeat:
+    // a child must not exit between our scan and going to sleep
+    preempt_disable();
     haskid = 0;
     if (pid != 0)
     {
-        proc = find_proc(pid);
-        if (proc != NULL && proc->parent == current)
+        spin_lock_irqsave(&proc_lock, intr_flag);
+        if ((proc = find_proc(pid)) != NULL && proc->parent != current)
+        {
+            proc = NULL;
+        }
+        // once it is known to be our child, only we can reap it
+        spin_unlock_irqrestore(&proc_lock, intr_flag);
+        if (proc != NULL)
         {
             haskid = 1;
             if (proc->state == PROC_ZOMBIE)
@@ -854,18 +1104,46 @@ repeat:
     }
     if (haskid)
     {
-        current->state = PROC_SLEEPING;
-        current->wait_state = WT_CHILD;
+        if (timer != NULL && list_empty(&(timer->timer_link)))
+        {
+            // the timer has fired
+            preempt_enable();
+            return -E_TIMEOUT;
+        }
+        wait_t __wait, *wait = &__wait;
+        local_intr_save(intr_flag);
+        wait_current_set(&(current->child_wait), wait, WT_CHILD);
+        local_intr_restore(intr_flag);
+        preempt_enable();
+
         schedule();
+
+        local_intr_save(intr_flag);
+        wait_current_del(&(current->child_wait), wait);
+        local_intr_restore(intr_flag);
         if (current->flags & PF_EXITING)
         {
+            if (timer != NULL)
+            {
+                del_timer(timer);
+            }
             do_exit(-E_KILLED);
         }
         goto repeat;
     }
+    preempt_enable();
+    if (timer != NULL)
+    {
+        del_timer(timer);
+    }
     return -E_BAD_PROC;
 
 found:
+    preempt_enable();
+    if (timer != NULL)
+    {
+        del_timer(timer);
+    }
     if (proc == idleproc || proc == initproc)
     {
         panic("wait idleproc or initproc.\n");
@@ -874,12 +1152,12 @@ found:
     {
         *code_store = proc->exit_code;
     }
-    local_intr_save(intr_flag);
+    spin_lock_irqsave(&proc_lock, intr_flag);
     {
         unhash_proc(proc);
         remove_links(proc);
     }
-    local_intr_restore(intr_flag);
+    spin_unlock_irqrestore(&proc_lock, intr_flag);
     put_kstack(proc);
     kfree(proc);
     return 0;
@@ -889,20 +1167,26 @@ found:
 int do_kill(int pid)
 {
     struct proc_struct *proc;
-    if ((proc = find_proc(pid)) != NULL)
+    bool intr_flag;
+    int ret = -E_INVAL;
+    spin_lock_irqsave(&proc_lock, intr_flag);
     {
-        if (!(proc->flags & PF_EXITING))
+        if ((proc = find_proc(pid)) != NULL)
         {
-            proc->flags |= PF_EXITING;
-            if (proc->wait_state & WT_INTERRUPTED)
+            ret = -E_KILLED;
+            if (!(proc->flags & PF_EXITING))
             {
-                wakeup_proc(proc);
+                proc->flags |= PF_EXITING;
+                if (proc->wait_state & WT_INTERRUPTED)
+                {
+                    wakeup_proc(proc);
+                }
+                ret = 0;
             }
-            return 0;
         }
-        return -E_KILLED;
     }
-    return -E_INVAL;
+    spin_unlock_irqrestore(&proc_lock, intr_flag);
+    return ret;
 }
 
 // kernel_execve - do SYS_exec syscall to exec a user program called by user_main kernel_thread
@@ -923,7 +1207,7 @@ kernel_execve(const char *name, unsigned char *binary, size_t size)
         : "=m"(ret)
         : "i"(SYS_exec), "m"(name), "m"(len), "m"(binary), "m"(size)
         : "memory");
-    cprintf("ret = %d\n", ret);
+    klog(KLOG_DEBUG, "ret = %d\n", ret);
     return ret;
 }
 
@@ -966,6 +1250,7 @@ init_main(void *arg)
     size_t nr_free_pages_store = nr_free_pages();
     size_t kernel_allocated_store = kallocated();
 
+    boot_summary();
     int pid = kernel_thread(user_main, NULL, 0);
     if (pid <= 0)
     {
@@ -1008,6 +1293,7 @@ void proc_init(void)
     idleproc->state = PROC_RUNNABLE;
     idleproc->kstack = (uintptr_t)bootstack;
     idleproc->need_resched = 1;
+    idleproc->cpu = mycpu()->id;
     set_proc_name(idleproc, "idle");
     nr_process++;
 
@@ -1019,13 +1305,52 @@ void proc_init(void)
         panic("create init_main failed.\n");
     }
 
+    bool intr_flag;
+    spin_lock_irqsave(&proc_lock, intr_flag);
     initproc = find_proc(pid);
     set_proc_name(initproc, "init");
+    spin_unlock_irqrestore(&proc_lock, intr_flag);
 
     assert(idleproc != NULL && idleproc->pid == 0);
     assert(initproc != NULL && initproc->pid == 1);
 }
 
+/* *
+ * idle_create - make the idle process of a secondary hart. The hart boots
+ * on its kernel stack and runs cpu_idle in it, so it needs no context of
+ * its own. Like the boot hart's, it has pid 0; it is not on proc_list and
+ * not counted in nr_process, only reachable through @cpu.
+ * */
+int idle_create(struct cpu *cpu)
+{
+    struct proc_struct *proc;
+    if ((proc = alloc_proc()) == NULL)
+    {
+        return -E_NO_MEM;
+    }
+    if (setup_kstack(proc) != 0)
+    {
+        kfree(proc);
+        return -E_NO_MEM;
+    }
+    proc->pid = 0;
+    proc->state = PROC_RUNNABLE;
+    proc->need_resched = 1;
+    proc->cpu = cpu->id;
+    set_proc_name(proc, "idle");
+    cpu->idle_proc = cpu->cur_proc = proc;
+    return 0;
+}
+
+// idle_destroy - undo idle_create for a hart that failed to start
+void idle_destroy(struct cpu *cpu)
+{
+    struct proc_struct *proc = cpu->idle_proc;
+    cpu->idle_proc = cpu->cur_proc = NULL;
+    put_kstack(proc);
+    kfree(proc);
+}
+
 // cpu_idle - at the end of kern_init, the first kernel thread idleproc will do below works
 void cpu_idle(void)
 {
@@ -1034,6 +1359,31 @@ void cpu_idle(void)
         if (current->need_resched)
         {
             schedule();
+            continue;
+        }
+        // nothing to run: stop the tick and halt until an interrupt arrives.
+        // wfi wakes on a pending interrupt even with sstatus.SIE clear, so
+        // checking need_resched with interrupts off closes the race with a
+        // wakeup from an interrupt handler; the handler runs on restore.
+        bool intr_flag;
+        local_intr_save(intr_flag);
+        {
+            // log records queued from interrupt handlers are printed here
+            klog_flush();
+            if (!current->need_resched)
+            {
+                clock_tick_stop();
+                // let the other harts into the kernel while this one sleeps
+                kernel_unlock();
+                asm volatile("wfi");
+                kernel_lock();
+                clock_tick_restart();
+                if (mycpu() == &cpus[0])
+                {
+                    run_timer_list();
+                }
+            }
         }
+        local_intr_restore(intr_flag);
     }
 }
@@ -5,6 +5,9 @@
 #include <list.h>
 #include <trap.h>
 #include <memlayout.h>
+#include <wait.h>
+#include <unistd.h>
+#include <smp.h>
 
 // process's state in his life cycle
 enum proc_state
@@ -39,6 +42,8 @@ struct context
 
 extern list_entry_t proc_list;
 
+struct perf_ctx;
+
 struct proc_struct
 {
     enum proc_state state;                  // Process state
@@ -58,31 +63,71 @@ struct proc_struct
     int exit_code;                          // exit code (be sent to parent proc)
     uint32_t wait_state;                    // waiting state
     struct proc_struct *cptr, *yptr, *optr; // relations between processes
+    wait_queue_t child_wait;                // sleep here in do_wait until a child exits
+    int preempt_count;                      // > 0: in an atomic section, must not be preempted
+    struct files_struct *filesp;            // the file descriptor table, NULL for kernel threads
+    struct proc_struct *ipc_partner;        // the server we called, or the client we owe a reply
+    wait_queue_t ipc_senders;               // callers waiting for us to enter reply_wait
+    uint64_t ipc_msg[IPC_MSG_WORDS];        // the message delivered to us
+    int ipc_status;                         // the outcome of our last call, set by the server side
+    list_entry_t run_link;                  // entry in a hart's run queue
+    struct run_queue *rq;                   // the run queue we are on, NULL if none
+    int cpu;                                // the hart (index in cpus[]) we last ran on
+    struct perf_ctx *perf;                  // performance counters we opened, NULL if none
 };
 
 #define PF_EXITING 0x00000001 // getting shutdown
 
 #define WT_CHILD (0x00000001 | WT_INTERRUPTED)
+#define WT_TIMER (0x00000002 | WT_INTERRUPTED)
+#define WT_KBD (0x00000004 | WT_INTERRUPTED)
+#define WT_FUTEX (0x00000008 | WT_INTERRUPTED)
+#define WT_PIPE (0x00000010 | WT_INTERRUPTED)
+#define WT_IPC_SEND (0x00000020 | WT_INTERRUPTED)  // call: wait for the server to receive
+#define WT_IPC_REPLY (0x00000040 | WT_INTERRUPTED) // call: wait for the server to reply
+#define WT_IPC_RECV (0x00000080 | WT_INTERRUPTED)  // reply_wait: wait for a call
+#define WT_KSEM 0x00000100                // wait kernel semaphore
+#define WT_KWORK 0x00000200               // wait for workqueue work or flush
+#define WT_RWSEM_READ 0x00000400          // wait to read-lock an rw_semaphore
+#define WT_RWSEM_WRITE 0x00000800         // wait to write-lock an rw_semaphore
 #define WT_INTERRUPTED 0x80000000 // the wait state could be interrupted
 
 #define le2proc(le, member) \
     to_struct((le), struct proc_struct, member)
 
-extern struct proc_struct *idleproc, *initproc, *current;
+extern struct proc_struct *initproc;
+
+// the idle process and the running process of this hart
+#define idleproc (mycpu()->idle_proc)
+#define current (mycpu()->cur_proc)
+
+/* *
+ * do_fork flag for kthread_create, never taken from user space: the child
+ * gets neither current's mm nor its descriptor table, whatever process
+ * happened to be running when the thread was asked for.
+ * */
+#define CLONE_KTHREAD 0x80000000
 
 void proc_init(void);
+int idle_create(struct cpu *cpu);
+void idle_destroy(struct cpu *cpu);
 void proc_run(struct proc_struct *proc);
 int kernel_thread(int (*fn)(void *), void *arg, uint32_t clone_flags);
+int kthread_create(int (*fn)(void *), void *arg, const char *name);
 
 char *set_proc_name(struct proc_struct *proc, const char *name);
 char *get_proc_name(struct proc_struct *proc);
 void cpu_idle(void) __attribute__((noreturn));
 
+void proc_table_lock(void);
+void proc_table_unlock(void);
 struct proc_struct *find_proc(int pid);
 int do_fork(uint32_t clone_flags, uintptr_t stack, struct trapframe *tf);
 int do_exit(int error_code);
 int do_yield(void);
 int do_execve(const char *name, size_t len, unsigned char *binary, size_t size);
 int do_wait(int pid, int *code_store);
+int do_wait_timeout(int pid, int *code_store, size_t timeout);
+int do_sleep(unsigned int time);
 int do_kill(int pid);
 #endif /* !__KERN_PROCESS_PROC_H__ */
@@ -0,0 +1,180 @@
+#include <defs.h>
+#include <list.h>
+#include <riscv.h>
+#include <sbi.h>
+#include <sync.h>
+#include <intr.h>
+#include <memlayout.h>
+#include <pmm.h>
+#include <dtb.h>
+#include <trap.h>
+#include <clock.h>
+#include <proc.h>
+#include <sched.h>
+#include <stdio.h>
+#include <assert.h>
+#include <perf.h>
+#include <smp.h>
+#include <spinlock.h>
+
+struct cpu cpus[NCPU];
+// the number of entries of cpus[] in use, online or coming up
+int ncpu = 1;
+
+// the firmware has the v0.2 IPI and RFENCE extensions, rather than only the legacy calls
+static bool has_ipi_ext, has_rfence_ext;
+
+static spinlock_t kernel_spinlock = SPINLOCK_INIT("kernel");
+
+void kernel_lock(void)
+{
+    spin_lock(&kernel_spinlock);
+}
+
+void kernel_unlock(void)
+{
+    spin_unlock(&kernel_spinlock);
+}
+
+// kernel_lock_enter - take the kernel lock unless this hart holds it already; returns 1 if it did
+bool kernel_lock_enter(void)
+{
+    if (spin_holding(&kernel_spinlock))
+    {
+        return 0;
+    }
+    kernel_lock();
+    return 1;
+}
+
+// smp_init - set up the boot hart's struct cpu, which entry.S has put in tp
+void smp_init(void)
+{
+    int i;
+    for (i = 0; i < NCPU; i++)
+    {
+        cpus[i].id = i;
+        list_init(&(cpus[i].rq.run_list));
+        cpus[i].rq.proc_num = 0;
+    }
+    assert(mycpu() == &cpus[0]);
+    cpus[0].hartid = boot_hartid;
+    cpus[0].online = 1;
+    kernel_lock();
+    set_csr(sie, MIP_SSIP);
+}
+
+static void
+send_ipi(struct cpu *cpu)
+{
+    if (has_ipi_ext)
+    {
+        sbi_send_ipi_mask(1, cpu->hartid);
+    }
+    else
+    {
+        unsigned long mask = 1UL << cpu->hartid;
+        sbi_send_ipi(&mask);
+    }
+}
+
+// smp_send_resched - make @cpu, which may be halted in its idle loop, look at its run queue
+void smp_send_resched(struct cpu *cpu)
+{
+    if (cpu != mycpu() && cpu->online)
+    {
+        send_ipi(cpu);
+    }
+}
+
+/* *
+ * smp_tlb_invalidate - flush @la from the TLBs of the other harts that run
+ * on the page table at @pgdir_pa. Harts that run on other page tables have
+ * no stale entries: proc_run flushes the TLB when it switches satp.
+ * */
+void smp_tlb_invalidate(uintptr_t pgdir_pa, uintptr_t la)
+{
+    unsigned long mask = 0;
+    int i;
+    for (i = 0; i < ncpu; i++)
+    {
+        struct cpu *cpu = &cpus[i];
+        if (cpu != mycpu() && cpu->online && cpu->cur_proc != NULL && cpu->cur_proc->pgdir == pgdir_pa)
+        {
+            mask |= 1UL << cpu->hartid;
+        }
+    }
+    if (mask != 0)
+    {
+        if (has_rfence_ext)
+        {
+            sbi_remote_sfence_vma_mask(mask, 0, la, PGSIZE);
+        }
+        else
+        {
+            sbi_remote_sfence_vma(&mask, la, PGSIZE);
+        }
+    }
+}
+
+// secondary_init - the first C code a secondary hart runs, on its idle process' stack
+void secondary_init(void) __attribute__((noreturn));
+void secondary_init(void)
+{
+    struct cpu *cpu = mycpu();
+    idt_init();
+    kernel_lock();
+    clock_init_hart();
+    perf_init_hart();
+    set_csr(sie, MIP_SSIP);
+    cpu->online = 1;
+    cprintf("smp: hart %d online as cpu %d.\n", cpu->hartid, cpu->id);
+    intr_enable();
+    cpu_idle();
+}
+
+/* *
+ * smp_boot - start every other hart the firmware reports as stopped,
+ * through the SBI HSM extension. Each one gets an idle process whose
+ * kernel stack it boots on; it waits for the kernel lock and then joins
+ * the scheduler from its idle loop.
+ * */
+void smp_boot(void)
+{
+    extern char secondary_entry[];
+    if (!sbi_probe_extension(SBI_EXT_HSM))
+    {
+        cprintf("smp: no SBI HSM extension, running on one hart.\n");
+        return;
+    }
+    has_ipi_ext = sbi_probe_extension(SBI_EXT_IPI);
+    has_rfence_ext = sbi_probe_extension(SBI_EXT_RFENCE);
+
+    unsigned long hartid;
+    for (hartid = 0; hartid < NCPU && ncpu < NCPU; hartid++)
+    {
+        if (hartid == boot_hartid)
+        {
+            continue;
+        }
+        struct sbiret status = sbi_hart_get_status(hartid);
+        if (status.error != SBI_SUCCESS || status.value != SBI_HSM_STATE_STOPPED)
+        {
+            continue;
+        }
+        struct cpu *cpu = &cpus[ncpu];
+        cpu->hartid = hartid;
+        if (idle_create(cpu) != 0)
+        {
+            break;
+        }
+        cpu->stacktop = cpu->idle_proc->kstack + KSTACKSIZE;
+        if (sbi_hart_start(hartid, PADDR(secondary_entry), (uintptr_t)cpu).error != SBI_SUCCESS)
+        {
+            idle_destroy(cpu);
+            continue;
+        }
+        ncpu++;
+    }
+    cprintf("smp: starting %d hart(s).\n", ncpu);
+}
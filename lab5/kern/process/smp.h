@@ -0,0 +1,68 @@
+#ifndef __KERN_PROCESS_SMP_H__
+#define __KERN_PROCESS_SMP_H__
+
+#include <defs.h>
+#include <list.h>
+
+// the most harts we bring up
+#define NCPU 8
+
+struct proc_struct;
+
+// the runnable processes waiting for one hart
+struct run_queue
+{
+    list_entry_t run_list;
+    int proc_num;
+};
+
+/* *
+ * Per-hart data. While a hart runs kernel code, tp points to its struct
+ * cpu; the trap entry path re-loads tp when it comes from user mode (see
+ * kern/trap/trapentry.S). cpus[0] is the boot hart.
+ * */
+struct cpu
+{
+    uintptr_t stacktop;             // the boot stack of a secondary hart, used by entry.S: keep first
+    int id;                         // index in cpus[]
+    int hartid;
+    volatile bool online;
+    struct proc_struct *cur_proc;   // the process running on this hart, see current in proc.h
+    struct proc_struct *idle_proc;  // this hart's idle process
+    struct run_queue rq;
+    size_t ticks;                   // timer interrupts taken by this hart
+    int irq_nesting;                // interrupt handlers running on this hart
+    uint64_t idle_start;            // when the idle loop stopped the tick
+    bool tick_stopped;
+};
+
+extern struct cpu cpus[NCPU];
+extern int ncpu;
+
+static inline struct cpu *
+mycpu(void)
+{
+    struct cpu *cpu;
+    // volatile: a process may move to another hart at every switch
+    asm volatile("mv %0, tp" : "=r"(cpu));
+    return cpu;
+}
+
+/* *
+ * The kernel lock. A hart runs kernel code only while it holds it; it is
+ * taken on every trap from user mode and dropped when returning there, or
+ * when the idle loop halts. User code thus runs in parallel on all harts
+ * while the kernel, much of which still relies on local_intr_save for
+ * mutual exclusion, stays serialized. Code that is already guarded by
+ * its own spinlocks (see kern/sync/spinlock.h) is safe without it.
+ * */
+void kernel_lock(void);
+void kernel_unlock(void);
+bool kernel_lock_enter(void);
+
+void smp_init(void);
+void smp_boot(void);
+void smp_send_resched(struct cpu *cpu);
+void smp_tlb_invalidate(uintptr_t pgdir_pa, uintptr_t la);
+
+#endif /* !__KERN_PROCESS_SMP_H__ */
@@ -0,0 +1,302 @@
+#include <defs.h>
+#include <list.h>
+#include <sync.h>
+#include <wait.h>
+#include <proc.h>
+#include <sched.h>
+#include <trap.h>
+#include <kmalloc.h>
+#include <assert.h>
+#include <workqueue.h>
+
+#define SYSTEM_WQ_WORKERS 2
+
+struct workqueue_struct *system_wq = NULL;
+
+// workqueue_init - create system_wq; its workers are started on first use
+void workqueue_init(void)
+{
+    if ((system_wq = create_workqueue("events", SYSTEM_WQ_WORKERS)) == NULL)
+    {
+        panic("cannot create system workqueue.\n");
+    }
+}
+
+// create_workqueue - create a queue run by at most @max_workers threads
+struct workqueue_struct *
+create_workqueue(const char *name, int max_workers)
+{
+    struct workqueue_struct *wq = kmalloc(sizeof(struct workqueue_struct));
+    if (wq != NULL)
+    {
+        wq->name = name;
+        wq->max_workers = (max_workers > 0) ? max_workers : 1;
+        wq->nr_workers = wq->nr_idle = 0;
+        wq->nr_pending = wq->nr_delayed = 0;
+        list_init(&(wq->work_list));
+        wait_queue_init(&(wq->idle_queue));
+        wait_queue_init(&(wq->flush_queue));
+    }
+    return wq;
+}
+
+// worker_idle_timeout - timer callback, lets an idle worker check whether it should exit
+static void
+worker_idle_timeout(void *data)
+{
+    struct proc_struct *proc = data;
+    if (proc->state == PROC_SLEEPING)
+    {
+        wakeup_proc(proc);
+    }
+}
+
+// worker_thread - the body of every worker: run queued work, exit when idle for too long
+static int
+worker_thread(void *arg)
+{
+    struct workqueue_struct *wq = arg;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    while (1)
+    {
+        list_entry_t *le = list_next(&(wq->work_list));
+        if (le == &(wq->work_list))
+        {
+            wait_t __wait, *wait = &__wait;
+            timer_t __timer, *timer = timer_init_func(&__timer, worker_idle_timeout, current, WQ_IDLE_TICKS);
+            add_timer(timer);
+            wq->nr_idle++;
+            wait_current_set(&(wq->idle_queue), wait, WT_KWORK);
+            local_intr_restore(intr_flag);
+
+            schedule();
+
+            local_intr_save(intr_flag);
+            del_timer(timer);
+            wait_current_del(&(wq->idle_queue), wait);
+            wq->nr_idle--;
+            if (wait->wakeup_flags != WT_KWORK && list_empty(&(wq->work_list)) && wq->nr_delayed == 0)
+            {
+                break;
+            }
+            continue;
+        }
+        struct work_struct *work = le2work(le, entry);
+        list_del_init(le);
+        work->pending = 0;
+        local_intr_restore(intr_flag);
+
+        work->func(work);
+
+        local_intr_save(intr_flag);
+        if (--wq->nr_pending == 0)
+        {
+            wakeup_queue(&(wq->flush_queue), WT_KWORK, 1);
+        }
+    }
+    wq->nr_workers--;
+    local_intr_restore(intr_flag);
+    return 0;
+}
+
+/* *
+ * need_worker - make sure some worker will see the work on @wq: wake an
+ * idle one, or reserve a slot for a new one while the queue is below its
+ * limit and has more work than workers. Returns 1 if the caller has to
+ * start_worker() once it has re-enabled interrupts. Called with
+ * interrupts disabled.
+ * */
+static bool
+need_worker(struct workqueue_struct *wq)
+{
+    if (wq->nr_idle > 0)
+    {
+        wakeup_first(&(wq->idle_queue), WT_KWORK, 1);
+        return 0;
+    }
+    if (in_interrupt() || current == NULL || current == idleproc)
+    {
+        return 0;
+    }
+    if (wq->nr_workers < wq->max_workers && wq->nr_workers < wq->nr_pending + wq->nr_delayed)
+    {
+        wq->nr_workers++;
+        return 1;
+    }
+    return 0;
+}
+
+static void
+start_worker(struct workqueue_struct *wq)
+{
+    if (kthread_create(worker_thread, wq, "kworker") <= 0)
+    {
+        bool intr_flag;
+        local_intr_save(intr_flag);
+        wq->nr_workers--;
+        local_intr_restore(intr_flag);
+    }
+}
+
+// insert_work - put @work, already marked pending, at the tail of @wq
+static void
+insert_work(struct workqueue_struct *wq, struct work_struct *work)
+{
+    work->wq = wq;
+    list_add_before(&(wq->work_list), &(work->entry));
+    wq->nr_pending++;
+}
+
+// queue_work - queue @work on @wq, returns 0 if it was already pending
+bool queue_work(struct workqueue_struct *wq, struct work_struct *work)
+{
+    bool intr_flag, ret = 0, spawn = 0;
+    local_intr_save(intr_flag);
+    if (!work->pending)
+    {
+        work->pending = 1;
+        insert_work(wq, work);
+        spawn = need_worker(wq);
+        ret = 1;
+    }
+    local_intr_restore(intr_flag);
+    if (spawn)
+    {
+        start_worker(wq);
+    }
+    return ret;
+}
+
+/* *
+ * queue_work_nospawn - queue @work on @wq only if one of its workers is
+ * alive to run it, and wake that worker if it is idle. Never starts a
+ * thread, so unlike queue_work it may be called with spinlocks held.
+ * Returns 1 if @work was queued by this call.
+ * */
+bool queue_work_nospawn(struct workqueue_struct *wq, struct work_struct *work)
+{
+    bool intr_flag, ret = 0;
+    local_intr_save(intr_flag);
+    if (!work->pending && wq->nr_workers > 0)
+    {
+        work->pending = 1;
+        insert_work(wq, work);
+        if (wq->nr_idle > 0)
+        {
+            wakeup_first(&(wq->idle_queue), WT_KWORK, 1);
+        }
+        ret = 1;
+    }
+    local_intr_restore(intr_flag);
+    return ret;
+}
+
+// delayed_work_timer_fn - timer callback, moves a delayed work onto its queue
+static void
+delayed_work_timer_fn(void *data)
+{
+    struct delayed_work *dwork = data;
+    struct workqueue_struct *wq = dwork->work.wq;
+    wq->nr_delayed--;
+    insert_work(wq, &(dwork->work));
+    // never starts a thread here, a worker is kept alive while nr_delayed > 0
+    need_worker(wq);
+}
+
+// queue_delayed_work - queue @dwork on @wq @delay ticks from now, returns 0 if it was already pending
+bool queue_delayed_work(struct workqueue_struct *wq, struct delayed_work *dwork, size_t delay)
+{
+    if (delay == 0)
+    {
+        return queue_work(wq, &(dwork->work));
+    }
+    bool intr_flag, ret = 0, spawn = 0;
+    local_intr_save(intr_flag);
+    if (!dwork->work.pending)
+    {
+        dwork->work.pending = 1;
+        dwork->work.wq = wq;
+        wq->nr_delayed++;
+        add_timer(timer_init_func(&(dwork->timer), delayed_work_timer_fn, dwork, delay));
+        // keep a worker around to pick the work up when the timer fires
+        spawn = (wq->nr_workers == 0) && need_worker(wq);
+        ret = 1;
+    }
+    local_intr_restore(intr_flag);
+    if (spawn)
+    {
+        start_worker(wq);
+    }
+    return ret;
+}
+
+// cancel_work - take @work off its queue if it has not started running, returns 1 if it did
+bool cancel_work(struct work_struct *work)
+{
+    bool intr_flag, ret = 0;
+    local_intr_save(intr_flag);
+    if (work->pending && !list_empty(&(work->entry)))
+    {
+        struct workqueue_struct *wq = work->wq;
+        list_del_init(&(work->entry));
+        work->pending = 0;
+        if (--wq->nr_pending == 0)
+        {
+            wakeup_queue(&(wq->flush_queue), WT_KWORK, 1);
+        }
+        ret = 1;
+    }
+    local_intr_restore(intr_flag);
+    return ret;
+}
+
+// cancel_delayed_work - disarm @dwork or take it off its queue, returns 1 if it did
+bool cancel_delayed_work(struct delayed_work *dwork)
+{
+    bool intr_flag, ret;
+    local_intr_save(intr_flag);
+    if (dwork->work.pending && !list_empty(&(dwork->timer.timer_link)))
+    {
+        del_timer(&(dwork->timer));
+        dwork->work.wq->nr_delayed--;
+        dwork->work.pending = 0;
+        ret = 1;
+    }
+    else
+    {
+        ret = cancel_work(&(dwork->work));
+    }
+    local_intr_restore(intr_flag);
+    return ret;
+}
+
+// flush_workqueue - wait until all work queued on @wq so far has run; armed delayed work is not waited for
+void flush_workqueue(struct workqueue_struct *wq)
+{
+    bool intr_flag;
+    while (1)
+    {
+        local_intr_save(intr_flag);
+        if (wq->nr_pending == 0)
+        {
+            local_intr_restore(intr_flag);
+            break;
+        }
+        if (need_worker(wq))
+        {
+            local_intr_restore(intr_flag);
+            start_worker(wq);
+            continue;
+        }
+        wait_t __wait, *wait = &__wait;
+        wait_current_set(&(wq->flush_queue), wait, WT_KWORK);
+        local_intr_restore(intr_flag);
+
+        schedule();
+
+        local_intr_save(intr_flag);
+        wait_current_del(&(wq->flush_queue), wait);
+        local_intr_restore(intr_flag);
+    }
+}
@@ -0,0 +1,100 @@
+#ifndef __KERN_PROCESS_WORKQUEUE_H__
+#define __KERN_PROCESS_WORKQUEUE_H__
+
+#include <defs.h>
+#include <list.h>
+#include <wait.h>
+#include <sched.h>
+
+/* *
+ * Workqueues defer work to kernel threads. A caller fills in a
+ * work_struct (usually embedded in a bigger object) and queues it; one of
+ * the queue's worker threads later calls work->func(work) in process
+ * context, where it may sleep. Workers are started on demand, up to the
+ * queue's concurrency limit, and exit again after WQ_IDLE_TICKS without
+ * work, so none of them outlive the user processes that queued it.
+ *
+ * Threads can only be started from process context. Work queued from an
+ * interrupt handler is run by a worker that is already alive; a queue with
+ * armed delayed work keeps at least one worker for that reason. Code that
+ * may hold spinlocks uses queue_work_nospawn, which never starts a thread.
+ * */
+
+struct work_struct;
+struct workqueue_struct;
+
+typedef void (*work_func_t)(struct work_struct *work);
+
+struct work_struct
+{
+    list_entry_t entry;           // entry in wq->work_list
+    work_func_t func;
+    struct workqueue_struct *wq;  // the queue it was last queued on
+    bool pending;                 // queued (or its timer armed), not yet running
+};
+
+struct delayed_work
+{
+    struct work_struct work;
+    timer_t timer;                // queues work on work.wq when it fires
+};
+
+#define le2work(le, member) \
+    to_struct((le), struct work_struct, member)
+
+#define INIT_WORK(w, f)           \
+    do                            \
+    {                             \
+        list_init(&((w)->entry)); \
+        (w)->func = (f);          \
+        (w)->wq = NULL;           \
+        (w)->pending = 0;         \
+    } while (0)
+
+#define INIT_DELAYED_WORK(dw, f)              \
+    do                                        \
+    {                                         \
+        INIT_WORK(&((dw)->work), (f));        \
+        list_init(&((dw)->timer.timer_link)); \
+    } while (0)
+
+// how long an idle worker waits for new work before it exits
+#define WQ_IDLE_TICKS 5
+
+struct workqueue_struct
+{
+    const char *name;
+    int max_workers;              // concurrency limit
+    int nr_workers;               // worker threads alive
+    int nr_idle;                  // workers sleeping on idle_queue
+    int nr_pending;               // work queued or running
+    int nr_delayed;               // delayed work whose timer is armed
+    list_entry_t work_list;       // queued work, FIFO
+    wait_queue_t idle_queue;      // idle workers sleep here
+    wait_queue_t flush_queue;     // flush_workqueue sleeps here
+};
+
+extern struct workqueue_struct *system_wq;
+
+void workqueue_init(void);
+struct workqueue_struct *create_workqueue(const char *name, int max_workers);
+bool queue_work(struct workqueue_struct *wq, struct work_struct *work);
+bool queue_work_nospawn(struct workqueue_struct *wq, struct work_struct *work);
+bool queue_delayed_work(struct workqueue_struct *wq, struct delayed_work *dwork, size_t delay);
+bool cancel_work(struct work_struct *work);
+bool cancel_delayed_work(struct delayed_work *dwork);
+void flush_workqueue(struct workqueue_struct *wq);
+
+static inline bool
+schedule_work(struct work_struct *work)
+{
+    return queue_work(system_wq, work);
+}
+
+static inline bool
+schedule_delayed_work(struct delayed_work *dwork, size_t delay)
+{
+    return queue_delayed_work(system_wq, dwork, delay);
+}
+
+#endif /* !__KERN_PROCESS_WORKQUEUE_H__ */
@@ -3,10 +3,105 @@
 #include <proc.h>
 #include <sched.h>
 #include <assert.h>
+#include <stdio.h>
+#include <riscv.h>
+#include <trace.h>
+
+static list_entry_t timer_wheel[TV_LEVELS][TVN_SIZE];
+// the next tick run_timer_list has to process
+static size_t timer_jiffies;
+static size_t timer_count;
+
+// when the tick last asked current to reschedule, 0 if it has complied
+static uint64_t resched_stamp;
+// the longest it took to comply, in timer cycles
+static uint64_t resched_latency_max;
+static size_t nr_preempt;
+
+void sched_init(void)
+{
+    int level, i;
+    for (level = 0; level < TV_LEVELS; level++)
+    {
+        for (i = 0; i < TVN_SIZE; i++)
+        {
+            list_init(&timer_wheel[level][i]);
+        }
+    }
+    timer_jiffies = ticks;
+    timer_count = 0;
+}
+
+/* *
+ * Every hart has its own run queue of the runnable processes that are not
+ * running anywhere. A process that was running on a hart goes to the tail
+ * of that hart's queue when it is switched out; a woken-up process goes to
+ * the queue of the hart picked by select_cpu. A hart whose queue is empty
+ * steals from the others before it goes idle.
+ * */
+static void
+rq_enqueue(struct run_queue *rq, struct proc_struct *proc)
+{
+    assert(proc->rq == NULL);
+    list_add_before(&(rq->run_list), &(proc->run_link));
+    proc->rq = rq;
+    rq->proc_num++;
+}
+
+static void
+rq_dequeue(struct proc_struct *proc)
+{
+    struct run_queue *rq = proc->rq;
+    if (rq != NULL)
+    {
+        list_del_init(&(proc->run_link));
+        proc->rq = NULL;
+        rq->proc_num--;
+    }
+}
+
+static struct proc_struct *
+rq_pick_next(struct run_queue *rq)
+{
+    list_entry_t *le = list_next(&(rq->run_list));
+    return (le != &(rq->run_list)) ? le2proc(le, run_link) : NULL;
+}
+
+// cpu_is_idle - is @cpu halted in its idle loop with nothing queued?
+static inline bool
+cpu_is_idle(struct cpu *cpu)
+{
+    return cpu->online && cpu->cur_proc == cpu->idle_proc && cpu->rq.proc_num == 0;
+}
+
+// select_cpu - the hart @proc should run on: where it ran last, unless that one is busy and another idles
+static struct cpu *
+select_cpu(struct proc_struct *proc)
+{
+    struct cpu *last = &cpus[proc->cpu];
+    int i;
+    if (!last->online)
+    {
+        last = mycpu();
+    }
+    if (cpu_is_idle(last))
+    {
+        return last;
+    }
+    for (i = 0; i < ncpu; i++)
+    {
+        if (cpu_is_idle(&cpus[i]))
+        {
+            return &cpus[i];
+        }
+    }
+    return last;
+}
 
 void wakeup_proc(struct proc_struct *proc)
 {
     assert(proc->state != PROC_ZOMBIE);
+    trace(TRACE_WAKEUP, proc->pid, proc->cpu);
     bool intr_flag;
     local_intr_save(intr_flag);
     {
@@ -14,6 +109,18 @@ void wakeup_proc(struct proc_struct *proc)
         {
             proc->state = PROC_RUNNABLE;
             proc->wait_state = 0;
+            // a process woken up before it got to switch out stays where it is
+            if (proc != current)
+            {
+                struct cpu *cpu = select_cpu(proc);
+                rq_enqueue(&(cpu->rq), proc);
+                if (cpu->cur_proc == cpu->idle_proc)
+                {
+                    // the idle loop halts the hart, so tell it there is work now
+                    cpu->idle_proc->need_resched = 1;
+                    smp_send_resched(cpu);
+                }
+            }
         }
         else
         {
@@ -26,25 +133,39 @@ void wakeup_proc(struct proc_struct *proc)
 void schedule(void)
 {
     bool intr_flag;
-    list_entry_t *le, *last;
-    struct proc_struct *next = NULL;
+    struct proc_struct *next;
     local_intr_save(intr_flag);
     {
+        trace(TRACE_SCHED, current->need_resched, current->state);
+        if (resched_stamp != 0)
+        {
+            uint64_t latency = rdtime() - resched_stamp;
+            if (latency > resched_latency_max)
+            {
+                resched_latency_max = latency;
+            }
+            resched_stamp = 0;
+        }
+        struct run_queue *rq = &(mycpu()->rq);
         current->need_resched = 0;
-        last = (current == idleproc) ? &proc_list : &(current->list_link);
-        le = last;
-        do
+        if (current->state == PROC_RUNNABLE && current != idleproc)
+        {
+            rq_enqueue(rq, current);
+        }
+        if ((next = rq_pick_next(rq)) == NULL)
         {
-            if ((le = list_next(le)) != &proc_list)
+            int i;
+            for (i = 0; i < ncpu && next == NULL; i++)
             {
-                next = le2proc(le, list_link);
-                if (next->state == PROC_RUNNABLE)
-                {
-                    break;
-                }
+                next = rq_pick_next(&(cpus[i].rq));
             }
-        } while (le != last);
-        if (next == NULL || next->state != PROC_RUNNABLE)
+        }
+        if (next != NULL)
+        {
+            rq_dequeue(next);
+            next->cpu = mycpu()->id;
+        }
+        else
         {
             next = idleproc;
         }
@@ -56,3 +177,218 @@ void schedule(void)
     }
     local_intr_restore(intr_flag);
 }
+
+/* *
+ * schedule_handoff - switch straight to @proc, which the caller has just
+ * woken up, rather than to whatever schedule() would pick. Current must
+ * not be runnable. Called with interrupts disabled.
+ * */
+void schedule_handoff(struct proc_struct *proc)
+{
+    assert(proc->state == PROC_RUNNABLE && current->state != PROC_RUNNABLE);
+    rq_dequeue(proc);
+    proc->cpu = mycpu()->id;
+    current->need_resched = 0;
+    proc->runs++;
+    proc_run(proc);
+}
+
+// wheel_insert - put @timer into the slot matching its distance from timer_jiffies
+static void
+wheel_insert(timer_t *timer)
+{
+    size_t expires = timer->expires;
+    if (expires < timer_jiffies)
+    {
+        expires = timer_jiffies;
+    }
+    size_t delta = expires - timer_jiffies;
+    int level = 0;
+    while (level < TV_LEVELS - 1 && delta >= ((size_t)1 << ((level + 1) * TVN_BITS)))
+    {
+        level++;
+    }
+    if (delta >= ((size_t)1 << (TV_LEVELS * TVN_BITS)))
+    {
+        // beyond the wheel: park it in the farthest slot, it is
+        // re-inserted with its real expiry when that slot cascades
+        expires = timer_jiffies + ((size_t)1 << (TV_LEVELS * TVN_BITS)) - 1;
+    }
+    int idx = (expires >> (level * TVN_BITS)) & TVN_MASK;
+    list_add_before(&timer_wheel[level][idx], &(timer->timer_link));
+}
+
+// add_timer - arm @timer, which must have been set up by timer_init(_func)
+void add_timer(timer_t *timer)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        assert((timer->proc != NULL || timer->func != NULL) &&
+               list_empty(&(timer->timer_link)));
+        if (timer_count == 0)
+        {
+            // the wheel may lag behind after a long idle period
+            timer_jiffies = ticks + 1;
+        }
+        wheel_insert(timer);
+        timer_count++;
+    }
+    local_intr_restore(intr_flag);
+}
+
+// del_timer - disarm @timer if it has not fired yet
+void del_timer(timer_t *timer)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        if (!list_empty(&(timer->timer_link)))
+        {
+            list_del_init(&(timer->timer_link));
+            timer_count--;
+        }
+    }
+    local_intr_restore(intr_flag);
+}
+
+// cascade - move every timer of one slot at @level down to the lower levels
+static int
+cascade(int level, int idx)
+{
+    list_entry_t head, *le;
+    list_init(&head);
+    if (!list_empty(&timer_wheel[level][idx]))
+    {
+        // splice the slot onto a private list, then re-insert each timer
+        list_add(&timer_wheel[level][idx], &head);
+        list_del_init(&timer_wheel[level][idx]);
+        while ((le = list_next(&head)) != &head)
+        {
+            list_del_init(le);
+            wheel_insert(le2timer(le, timer_link));
+        }
+    }
+    return idx;
+}
+
+/* *
+ * run_timer_list - called from the timer interrupt once ticks has been
+ * advanced. Wakes the owner of every timer that has expired, processing
+ * each tick the wheel has not seen yet (the idle loop may skip many).
+ * */
+void run_timer_list(void)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        while (timer_jiffies <= ticks)
+        {
+            if (timer_count == 0)
+            {
+                timer_jiffies = ticks + 1;
+                break;
+            }
+            int idx = timer_jiffies & TVN_MASK, level = 1;
+            while (idx == 0 && level < TV_LEVELS)
+            {
+                idx = cascade(level, (timer_jiffies >> (level * TVN_BITS)) & TVN_MASK);
+                level++;
+            }
+            list_entry_t *slot = &timer_wheel[0][timer_jiffies & TVN_MASK], *le;
+            while ((le = list_next(slot)) != slot)
+            {
+                timer_t *timer = le2timer(le, timer_link);
+                list_del_init(le);
+                timer_count--;
+                if (timer->func != NULL)
+                {
+                    timer->func(timer->data);
+                }
+                else if (timer->proc->state == PROC_SLEEPING)
+                {
+                    wakeup_proc(timer->proc);
+                }
+            }
+            timer_jiffies++;
+        }
+    }
+    local_intr_restore(intr_flag);
+}
+
+/* *
+ * timer_next_expiry - the tick by which run_timer_list must run again,
+ * or (size_t)-1 if no timer is armed. Timers on the higher levels are
+ * not searched; the next cascade point is reported instead.
+ * */
+size_t timer_next_expiry(void)
+{
+    size_t next = (size_t)-1;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    if (timer_count != 0)
+    {
+        size_t j = timer_jiffies;
+        while ((j & TVN_MASK) != 0 && list_empty(&timer_wheel[0][j & TVN_MASK]))
+        {
+            j++;
+        }
+        next = j;
+    }
+    local_intr_restore(intr_flag);
+    return next;
+}
+
+static inline bool
+__preemptible(void)
+{
+    return current != NULL && current->preempt_count == 0 &&
+           current->state == PROC_RUNNABLE;
+}
+
+// preemptible - may current be switched out right now?
+bool preemptible(void)
+{
+    return __preemptible() && (read_csr(sstatus) & SSTATUS_SIE);
+}
+
+// cond_resched - a preemption point for long-running kernel code
+void cond_resched(void)
+{
+    if (current != NULL && current->need_resched && preemptible())
+    {
+        nr_preempt++;
+        schedule();
+    }
+}
+
+/* *
+ * preempt_schedule_irq - called at the end of an interrupt that hit kernel
+ * code running with interrupts enabled. Interrupts are off here, but the
+ * interrupted code could have been switched out all the same.
+ * */
+void preempt_schedule_irq(void)
+{
+    if (current != NULL && current->need_resched && __preemptible())
+    {
+        nr_preempt++;
+        schedule();
+    }
+}
+
+// set_need_resched - called from the timer tick when current's time slice is used up
+void set_need_resched(void)
+{
+    if (current != NULL && !current->need_resched)
+    {
+        current->need_resched = 1;
+        resched_stamp = rdtime();
+    }
+}
+
+void print_sched_stats(void)
+{
+    cprintf("kernel preemptions: %ld\n", (long)nr_preempt);
+    cprintf("max tick-to-switch latency: %ld us\n",
+            (long)clock_cycles_to_usec(resched_latency_max));
+}
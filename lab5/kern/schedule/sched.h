@@ -1,10 +1,101 @@
 #ifndef __KERN_SCHEDULE_SCHED_H__
 #define __KERN_SCHEDULE_SCHED_H__
 
+#include <defs.h>
+#include <list.h>
+#include <clock.h>
 #include <proc.h>
 
+/* *
+ * Kernel timers live on a hierarchical timing wheel: TV_LEVELS levels of
+ * TVN_SIZE slots each. Level 0 holds timers due within the next TVN_SIZE
+ * ticks, one slot per tick; every higher level covers TVN_SIZE times the
+ * range of the one below and is cascaded down as time passes. Adding and
+ * cancelling a timer is O(1).
+ * */
+#define TVN_BITS 6
+#define TVN_SIZE (1 << TVN_BITS)
+#define TVN_MASK (TVN_SIZE - 1)
+#define TV_LEVELS 4
+
+typedef struct
+{
+    size_t expires;           // the tick at which the timer fires
+    struct proc_struct *proc; // the process to wake up when it fires
+    void (*func)(void *data); // or, if set, call this from the timer interrupt
+    void *data;
+    list_entry_t timer_link;  // entry in a slot of the timing wheel
+} timer_t;
+
+#define le2timer(le, member) \
+    to_struct((le), timer_t, member)
+
+// timer_init - initialize a timer that fires @expires ticks from now
+static inline timer_t *
+timer_init(timer_t *timer, struct proc_struct *proc, size_t expires)
+{
+    timer->expires = ticks + expires;
+    timer->proc = proc;
+    timer->func = NULL;
+    timer->data = NULL;
+    list_init(&(timer->timer_link));
+    return timer;
+}
+
+// timer_init_func - initialize a timer that calls @func(@data) @expires ticks from now
+static inline timer_t *
+timer_init_func(timer_t *timer, void (*func)(void *), void *data, size_t expires)
+{
+    timer_init(timer, NULL, expires);
+    timer->func = func;
+    timer->data = data;
+    return timer;
+}
+
+/* *
+ * Kernel preemption. A process may be switched out on a timer interrupt
+ * even while it runs in the kernel, unless it is inside a
+ * preempt_disable()/preempt_enable() section, has interrupts disabled,
+ * or is not runnable (i.e. on its way to sleep). Long kernel loops call
+ * cond_resched() to offer a switch explicitly.
+ * */
+static inline void
+preempt_disable(void)
+{
+    if (current != NULL)
+    {
+        current->preempt_count++;
+        __asm__ __volatile__("" ::: "memory");
+    }
+}
+
+void cond_resched(void);
+void preempt_schedule_irq(void);
+
+static inline void
+preempt_enable(void)
+{
+    if (current != NULL)
+    {
+        __asm__ __volatile__("" ::: "memory");
+        if (--current->preempt_count == 0 && current->need_resched)
+        {
+            cond_resched();
+        }
+    }
+}
+
+void sched_init(void);
 void schedule(void);
+void schedule_handoff(struct proc_struct *proc);
+bool preemptible(void);
+void set_need_resched(void);
+void print_sched_stats(void);
 void wakeup_proc(struct proc_struct *proc);
+void add_timer(timer_t *timer);
+void del_timer(timer_t *timer);
+void run_timer_list(void);
+size_t timer_next_expiry(void);
 
 #endif /* !__KERN_SCHEDULE_SCHED_H__ */
 
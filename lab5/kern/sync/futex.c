@@ -0,0 +1,165 @@
+#include <defs.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <error.h>
+#include <sync.h>
+#include <wait.h>
+#include <proc.h>
+#include <sched.h>
+#include <vmm.h>
+#include <futex.h>
+
+/* *
+ * Fast user-space mutexes. A user lock word lives in ordinary user memory
+ * and is only touched with atomic instructions while uncontended; the
+ * kernel is entered only to sleep on the word (FUTEX_WAIT) or to wake its
+ * sleepers (FUTEX_WAKE, FUTEX_REQUEUE).
+ *
+ * Sleepers are keyed by (mm, user virtual address), so only processes
+ * sharing an address space (CLONE_VM) can meet on a futex. They are kept
+ * in a small hash table of wait queues; a queue may hold sleepers for
+ * several keys, so wakers compare the key of every entry.
+ * */
+
+#define FUTEX_HASH_SHIFT 6
+#define FUTEX_HASH_SIZE (1 << FUTEX_HASH_SHIFT)
+
+static wait_queue_t futex_queues[FUTEX_HASH_SIZE];
+
+// a process sleeping in FUTEX_WAIT, lives on its kernel stack
+struct futex_q
+{
+    wait_t wait;
+    struct mm_struct *mm;
+    uintptr_t uaddr;
+};
+
+#define wait2futex(w) \
+    to_struct((w), struct futex_q, wait)
+
+static wait_queue_t *
+futex_hash(struct mm_struct *mm, uintptr_t uaddr)
+{
+    uint32_t key = (uint32_t)(uaddr >> 2) ^ (uint32_t)((uintptr_t)mm >> 4);
+    return futex_queues + hash32(key, FUTEX_HASH_SHIFT);
+}
+
+void futex_init(void)
+{
+    int i;
+    for (i = 0; i < FUTEX_HASH_SIZE; i++)
+    {
+        wait_queue_init(futex_queues + i);
+    }
+}
+
+/* *
+ * futex_wait - sleep until woken on @uaddr, but only if it still holds
+ * @val. The check and the enqueue happen with interrupts disabled, so a
+ * wakeup sent after the user changed the word cannot be missed.
+ * */
+static int
+futex_wait(struct mm_struct *mm, uintptr_t uaddr, int val)
+{
+    struct futex_q q;
+    wait_queue_t *queue = futex_hash(mm, uaddr);
+    int cur;
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    if (!copy_from_user(mm, &cur, (const void *)uaddr, sizeof(int), 0))
+    {
+        local_intr_restore(intr_flag);
+        return -E_INVAL;
+    }
+    if (cur != val)
+    {
+        local_intr_restore(intr_flag);
+        return -E_AGAIN;
+    }
+    q.mm = mm;
+    q.uaddr = uaddr;
+    wait_current_set(queue, &(q.wait), WT_FUTEX);
+    local_intr_restore(intr_flag);
+
+    schedule();
+
+    local_intr_save(intr_flag);
+    // FUTEX_REQUEUE may have moved us, so use the queue we are on now
+    wait_current_del(q.wait.wait_queue, &(q.wait));
+    local_intr_restore(intr_flag);
+
+    if (q.wait.wakeup_flags != WT_FUTEX)
+    {
+        return -E_KILLED;
+    }
+    return 0;
+}
+
+/* *
+ * futex_wake - wake up to @nr_wake sleepers on @uaddr, then move up to
+ * @nr_requeue of the remaining ones over to @uaddr2 without waking them.
+ * Returns the number of sleepers woken or moved.
+ * */
+static int
+futex_wake(struct mm_struct *mm, uintptr_t uaddr, int nr_wake,
+           int nr_requeue, uintptr_t uaddr2)
+{
+    wait_queue_t *queue = futex_hash(mm, uaddr), *queue2 = NULL;
+    int ret = 0;
+    if (nr_requeue > 0)
+    {
+        queue2 = futex_hash(mm, uaddr2);
+    }
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    {
+        wait_t *wait = wait_queue_first(queue), *next;
+        for (; wait != NULL && (nr_wake > 0 || nr_requeue > 0); wait = next)
+        {
+            next = wait_queue_next(queue, wait);
+            struct futex_q *q = wait2futex(wait);
+            if (q->mm != mm || q->uaddr != uaddr)
+            {
+                continue;
+            }
+            if (nr_wake > 0)
+            {
+                wakeup_wait(queue, wait, WT_FUTEX, 1);
+                nr_wake--;
+            }
+            else
+            {
+                wait_queue_del(queue, wait);
+                q->uaddr = uaddr2;
+                wait_queue_add(queue2, wait);
+                nr_requeue--;
+            }
+            ret++;
+        }
+    }
+    local_intr_restore(intr_flag);
+    return ret;
+}
+
+int do_futex(uintptr_t uaddr, int op, int val, int val2, uintptr_t uaddr2)
+{
+    struct mm_struct *mm = current->mm;
+    if (mm == NULL || uaddr % sizeof(int) != 0)
+    {
+        return -E_INVAL;
+    }
+    switch (op)
+    {
+    case FUTEX_WAIT:
+        return futex_wait(mm, uaddr, val);
+    case FUTEX_WAKE:
+        return futex_wake(mm, uaddr, val, 0, 0);
+    case FUTEX_REQUEUE:
+        if (uaddr2 % sizeof(int) != 0 || !user_mem_check(mm, uaddr2, sizeof(int), 0))
+        {
+            return -E_INVAL;
+        }
+        return futex_wake(mm, uaddr, val, val2, uaddr2);
+    }
+    return -E_INVAL;
+}
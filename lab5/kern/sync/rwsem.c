@@ -0,0 +1,144 @@
+#include <defs.h>
+#include <wait.h>
+#include <sync.h>
+#include <rwsem.h>
+#include <proc.h>
+#include <sched.h>
+#include <riscv.h>
+#include <string.h>
+#include <assert.h>
+
+void init_rwsem(rw_semaphore_t *sem)
+{
+    sem->count = 0;
+    wait_queue_init(&(sem->wait_queue));
+    memset(&(sem->stat), 0, sizeof(sem->stat));
+}
+
+/* *
+ * rwsem_grant - give the free semaphore to the sleepers at the head of
+ * the queue. They find it held on their behalf when they wake up.
+ * Called with interrupts disabled.
+ * */
+static void
+rwsem_grant(rw_semaphore_t *sem)
+{
+    wait_t *wait;
+    assert(sem->count == 0);
+    if ((wait = wait_queue_first(&(sem->wait_queue))) == NULL)
+    {
+        return;
+    }
+    if (wait->proc->wait_state == WT_RWSEM_WRITE)
+    {
+        sem->count = -1;
+        wakeup_wait(&(sem->wait_queue), wait, WT_RWSEM_WRITE, 1);
+        return;
+    }
+    while (wait != NULL && wait->proc->wait_state == WT_RWSEM_READ)
+    {
+        wait_t *next = wait_queue_next(&(sem->wait_queue), wait);
+        sem->count++;
+        wakeup_wait(&(sem->wait_queue), wait, WT_RWSEM_READ, 1);
+        wait = next;
+    }
+}
+
+// rwsem_sleep - queue current as a @wait_state sleeper and wait to be granted the semaphore
+static void
+rwsem_sleep(rw_semaphore_t *sem, uint32_t wait_state, bool *intr_flag)
+{
+    wait_t __wait, *wait = &__wait;
+    uint64_t start = rdtime();
+    wait_current_set(&(sem->wait_queue), wait, wait_state);
+    local_intr_restore(*intr_flag);
+
+    schedule();
+
+    local_intr_save(*intr_flag);
+    // the wait states are not interruptible, only a grant wakes us
+    assert(!wait_in_queue(wait) && wait->wakeup_flags == wait_state);
+    sem->stat.wait_cycles += rdtime() - start;
+}
+
+void down_read(rw_semaphore_t *sem)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    sem->stat.nr_read++;
+    if (sem->count >= 0 && wait_queue_empty(&(sem->wait_queue)))
+    {
+        sem->count++;
+    }
+    else
+    {
+        sem->stat.nr_read_wait++;
+        rwsem_sleep(sem, WT_RWSEM_READ, &intr_flag);
+    }
+    local_intr_restore(intr_flag);
+}
+
+void up_read(rw_semaphore_t *sem)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    assert(sem->count > 0);
+    if (--sem->count == 0)
+    {
+        rwsem_grant(sem);
+    }
+    local_intr_restore(intr_flag);
+}
+
+void down_write(rw_semaphore_t *sem)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    sem->stat.nr_write++;
+    if (sem->count == 0 && wait_queue_empty(&(sem->wait_queue)))
+    {
+        sem->count = -1;
+    }
+    else
+    {
+        sem->stat.nr_write_wait++;
+        rwsem_sleep(sem, WT_RWSEM_WRITE, &intr_flag);
+    }
+    local_intr_restore(intr_flag);
+}
+
+void up_write(rw_semaphore_t *sem)
+{
+    bool intr_flag;
+    local_intr_save(intr_flag);
+    assert(sem->count == -1);
+    sem->count = 0;
+    rwsem_grant(sem);
+    local_intr_restore(intr_flag);
+}
+
+bool down_read_trylock(rw_semaphore_t *sem)
+{
+    bool intr_flag, ret = 0;
+    local_intr_save(intr_flag);
+    if (sem->count >= 0 && wait_queue_empty(&(sem->wait_queue)))
+    {
+        sem->count++, ret = 1;
+        sem->stat.nr_read++;
+    }
+    local_intr_restore(intr_flag);
+    return ret;
+}
+
+bool down_write_trylock(rw_semaphore_t *sem)
+{
+    bool intr_flag, ret = 0;
+    local_intr_save(intr_flag);
+    if (sem->count == 0 && wait_queue_empty(&(sem->wait_queue)))
+    {
+        sem->count = -1, ret = 1;
+        sem->stat.nr_write++;
+    }
+    local_intr_restore(intr_flag);
+    return ret;
+}
@@ -0,0 +1,36 @@
+#ifndef __KERN_SYNC_RWSEM_H__
+#define __KERN_SYNC_RWSEM_H__
+
+#include <defs.h>
+#include <wait.h>
+
+/* *
+ * Reader/writer semaphore. Any number of readers, or one writer, may hold
+ * it; the others sleep on the wait queue in FIFO order. A reader queues
+ * as soon as anyone is waiting, so a stream of readers cannot starve a
+ * writer. Release hands the semaphore straight to the sleepers at the
+ * head of the queue: one writer, or every reader up to the next writer.
+ * */
+typedef struct
+{
+    int count;                  // readers holding it, -1 for a writer, 0 if free
+    wait_queue_t wait_queue;
+    struct rwsem_stat
+    {
+        size_t nr_read;         // down_read calls
+        size_t nr_write;        // down_write calls
+        size_t nr_read_wait;    // ... of which had to sleep
+        size_t nr_write_wait;
+        uint64_t wait_cycles;   // time spent asleep, in time CSR cycles
+    } stat;
+} rw_semaphore_t;
+
+void init_rwsem(rw_semaphore_t *sem);
+void down_read(rw_semaphore_t *sem);
+void up_read(rw_semaphore_t *sem);
+void down_write(rw_semaphore_t *sem);
+void up_write(rw_semaphore_t *sem);
+bool down_read_trylock(rw_semaphore_t *sem);
+bool down_write_trylock(rw_semaphore_t *sem);
+
+#endif /* !__KERN_SYNC_RWSEM_H__ */
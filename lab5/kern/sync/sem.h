@@ -0,0 +1,22 @@
+#ifndef __KERN_SYNC_SEM_H__
+#define __KERN_SYNC_SEM_H__
+
+#include <defs.h>
+#include <wait.h>
+
+/* *
+ * Counting semaphore. down() sleeps on the wait queue while the count is
+ * zero; up() hands the unit straight to the first sleeper, if any.
+ * */
+typedef struct
+{
+    int value;
+    wait_queue_t wait_queue;
+} semaphore_t;
+
+void sem_init(semaphore_t *sem, int value);
+void up(semaphore_t *sem);
+void down(semaphore_t *sem);
+bool try_down(semaphore_t *sem);
+
+#endif /* !__KERN_SYNC_SEM_H__ */
@@ -0,0 +1,124 @@
+#include <defs.h>
+#include <atomic.h>
+#include <riscv.h>
+#include <stdio.h>
+#include <assert.h>
+#include <clock.h>
+#include <smp.h>
+#include <spinlock.h>
+
+#ifdef LOCK_STAT
+// the locks that have been taken at least once, for lock_stat_print
+#define LOCK_STAT_MAX 64
+static spinlock_t *lock_stat_table[LOCK_STAT_MAX];
+static atomic_t nr_lock_stat = ATOMIC_INIT(0);
+
+static void
+lock_stat_register(spinlock_t *lock)
+{
+    int i = atomic_fetch_add(&nr_lock_stat, 1);
+    if (i < LOCK_STAT_MAX)
+    {
+        lock_stat_table[i] = lock;
+    }
+    lock->registered = 1;
+}
+#endif
+
+void spin_lock_init(spinlock_t *lock, const char *name)
+{
+    atomic_set(&(lock->next), 0);
+    lock->owner = 0;
+    lock->holder = NULL;
+    lock->name = name;
+#ifdef LOCK_STAT
+    lock->nr_acquired = lock->nr_contended = 0;
+    lock->wait_cycles = 0;
+    lock->registered = 0;
+#endif
+}
+
+void spin_lock(spinlock_t *lock)
+{
+    if (spin_holding(lock))
+    {
+        panic("spin_lock: %s already held by this hart.\n", lock->name);
+    }
+    int ticket = atomic_fetch_add(&(lock->next), 1);
+#ifdef LOCK_STAT
+    uint64_t start = 0;
+    if (lock->owner != ticket)
+    {
+        start = rdtime();
+    }
+#endif
+    while (lock->owner != ticket)
+    {
+        // spin on a plain load, the line stays shared until the unlock
+    }
+    // nothing of the critical section may be read before the lock is ours
+    __asm__ __volatile__("fence r, rw" ::: "memory");
+    lock->holder = mycpu();
+#ifdef LOCK_STAT
+    if (start != 0)
+    {
+        lock->nr_contended++;
+        lock->wait_cycles += rdtime() - start;
+    }
+    if (lock->nr_acquired++ == 0 && !lock->registered)
+    {
+        lock_stat_register(lock);
+    }
+#endif
+}
+
+// spin_trylock - take @lock if it is free right now; returns 1 on success
+bool spin_trylock(spinlock_t *lock)
+{
+    int owner = lock->owner;
+    if (atomic_cmpxchg(&(lock->next), owner, owner + 1) != owner)
+    {
+        return 0;
+    }
+    lock->holder = mycpu();
+#ifdef LOCK_STAT
+    if (lock->nr_acquired++ == 0 && !lock->registered)
+    {
+        lock_stat_register(lock);
+    }
+#endif
+    return 1;
+}
+
+void spin_unlock(spinlock_t *lock)
+{
+    if (!spin_holding(lock))
+    {
+        panic("spin_unlock: %s not held by this hart.\n", lock->name);
+    }
+    lock->holder = NULL;
+    // the critical section must be visible before the next hart gets in
+    __asm__ __volatile__("fence rw, w" ::: "memory");
+    lock->owner = (int)((unsigned int)lock->owner + 1);
+}
+
+// lock_stat_print - list the contention counters of every lock taken so far
+void lock_stat_print(void)
+{
+#ifdef LOCK_STAT
+    int i, n = atomic_read(&nr_lock_stat);
+    if (n > LOCK_STAT_MAX)
+    {
+        n = LOCK_STAT_MAX;
+    }
+    cprintf("%-12s %10s %10s %12s\n", "lock", "acquired", "contended", "wait(us)");
+    for (i = 0; i < n; i++)
+    {
+        spinlock_t *lock = lock_stat_table[i];
+        cprintf("%-12s %10ld %10ld %12ld\n", lock->name, (long)lock->nr_acquired,
+                (long)lock->nr_contended, (long)clock_cycles_to_usec(lock->wait_cycles));
+    }
+#else
+    cprintf("lock statistics are off, rebuild with DEFS+=-DLOCK_STAT.\n");
+#endif
+}
@@ -0,0 +1,75 @@
+#ifndef __KERN_SYNC_SPINLOCK_H__
+#define __KERN_SYNC_SPINLOCK_H__
+
+#include <defs.h>
+#include <atomic.h>
+#include <sync.h>
+#include <smp.h>
+
+/* *
+ * Ticket spinlock. A hart takes the next ticket with one amoadd and spins
+ * on a plain load until the lock serves it, so waiters get the lock in
+ * the order they asked for it and do not hammer the line with AMOs.
+ *
+ * A spinlock must not be held across anything that may sleep, and code
+ * that also runs from an interrupt handler must take it with the _irqsave
+ * variants, or the handler could spin forever on the lock of the code it
+ * interrupted. Build with LOCK_STAT defined (make DEFS+=-DLOCK_STAT) to
+ * count acquisitions, contention and time spent spinning on each lock;
+ * the kernel monitor prints them with `lockstat'.
+ * */
+typedef struct
+{
+    atomic_t next;          // the next ticket to hand out
+    volatile int owner;     // the ticket being served
+    struct cpu *holder;     // the hart holding the lock, NULL if free
+    const char *name;
+#ifdef LOCK_STAT
+    size_t nr_acquired;
+    size_t nr_contended;
+    uint64_t wait_cycles;   // time spent spinning, in time CSR cycles
+    bool registered;        // listed for lock_stat_print
+#endif
+} spinlock_t;
+
+#define SPINLOCK_INIT(lockname)                             \
+    {                                                       \
+        .next = ATOMIC_INIT(0), .owner = 0, .holder = NULL, \
+        .name = (lockname)                                  \
+    }
+
+void spin_lock_init(spinlock_t *lock, const char *name);
+void spin_lock(spinlock_t *lock);
+bool spin_trylock(spinlock_t *lock);
+void spin_unlock(spinlock_t *lock);
+
+// spin_holding - does this hart hold @lock?
+static inline bool
+spin_holding(spinlock_t *lock)
+{
+    return lock->holder == mycpu();
+}
+
+static inline bool
+spin_is_locked(spinlock_t *lock)
+{
+    return atomic_read(&(lock->next)) != lock->owner;
+}
+
+#define spin_lock_irqsave(lock, x) \
+    do                             \
+    {                              \
+        local_intr_save(x);        \
+        spin_lock(lock);           \
+    } while (0)
+
+#define spin_unlock_irqrestore(lock, x) \
+    do                                  \
+    {                                   \
+        spin_unlock(lock);              \
+        local_intr_restore(x);          \
+    } while (0)
+
+void lock_stat_print(void);
+
+#endif /* !__KERN_SYNC_SPINLOCK_H__ */
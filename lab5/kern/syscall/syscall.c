@@ -5,6 +5,15 @@
 #include <stdio.h>
 #include <pmm.h>
 #include <assert.h>
+#include <clock.h>
+#include <futex.h>
+#include <file.h>
+#include <ipc.h>
+#include <error.h>
+#include <vmm.h>
+#include <console.h>
+#include <trace.h>
+#include <perf.h>
 
 static int
 sys_exit(uint64_t arg[]) {
@@ -35,11 +44,56 @@ sys_exec(uint64_t arg[]) {
     return do_execve(name, len, binary, size);
 }
 
+static int
+sys_clone(uint64_t arg[]) {
+    uint32_t clone_flags = (uint32_t)arg[0] & ~CLONE_KTHREAD;
+    uintptr_t stack = (uintptr_t)arg[1];
+    if (stack == 0) {
+        // a thread sharing our mm cannot share our stack as well
+        return -E_INVAL;
+    }
+    return do_fork(clone_flags, stack, current->tf);
+}
+
 static int
 sys_yield(uint64_t arg[]) {
     return do_yield();
 }
 
+static int
+sys_sleep(uint64_t arg[]) {
+    unsigned int ms = (unsigned int)arg[0];
+    // round up so that the caller never sleeps for less than asked
+    return do_sleep((unsigned int)(((uint64_t)ms * TICK_HZ + 999) / 1000));
+}
+
+static int
+sys_gettime(uint64_t arg[]) {
+    return (int)((uint64_t)ticks * 1000 / TICK_HZ);
+}
+
+static int
+sys_futex(uint64_t arg[]) {
+    uintptr_t uaddr = (uintptr_t)arg[0];
+    int op = (int)arg[1];
+    int val = (int)arg[2];
+    int val2 = (int)arg[3];
+    uintptr_t uaddr2 = (uintptr_t)arg[4];
+    return do_futex(uaddr, op, val, val2, uaddr2);
+}
+
+static int
+sys_call(uint64_t arg[]) {
+    int pid = (int)arg[0];
+    return do_ipc_call(pid, &arg[1]);
+}
+
+static int
+sys_reply_wait(uint64_t arg[]) {
+    int pid = (int)arg[0];
+    return do_ipc_reply_wait(pid, &arg[1]);
+}
+
 static int
 sys_kill(uint64_t arg[]) {
     int pid = (int)arg[0];
@@ -58,6 +112,69 @@ sys_putc(uint64_t arg[]) {
     return 0;
 }
 
+// sys_puts - write @len bytes at @base to the console, in chunks through a kernel buffer
+static int
+sys_puts(uint64_t arg[]) {
+    const char *base = (const char *)arg[0];
+    size_t len = (size_t)arg[1], done = 0;
+    struct mm_struct *mm = current->mm;
+    char buf[128];
+    while (done < len) {
+        size_t n = (len - done < sizeof(buf)) ? len - done : sizeof(buf);
+        bool ok;
+        mmap_read_lock(mm);
+        ok = copy_from_user(mm, buf, base + done, n, 0);
+        mmap_read_unlock(mm);
+        if (!ok) {
+            return (done != 0) ? (int)done : -E_INVAL;
+        }
+        cons_write(buf, n);
+        done += n;
+    }
+    return (int)done;
+}
+
+static int
+sys_perf_open(uint64_t arg[]) {
+    int event = (int)arg[0];
+    return do_perf_open(event);
+}
+
+static int
+sys_perf_read(uint64_t arg[]) {
+    int event = (int)arg[0];
+    uint64_t *value_store = (uint64_t *)arg[1];
+    return do_perf_read(event, value_store);
+}
+
+static int
+sys_close(uint64_t arg[]) {
+    int fd = (int)arg[0];
+    return sysfile_close(fd);
+}
+
+static int
+sys_read(uint64_t arg[]) {
+    int fd = (int)arg[0];
+    void *base = (void *)arg[1];
+    size_t len = (size_t)arg[2];
+    return sysfile_read(fd, base, len);
+}
+
+static int
+sys_write(uint64_t arg[]) {
+    int fd = (int)arg[0];
+    void *base = (void *)arg[1];
+    size_t len = (size_t)arg[2];
+    return sysfile_write(fd, base, len);
+}
+
+static int
+sys_pipe(uint64_t arg[]) {
+    int *fd_store = (int *)arg[0];
+    return sysfile_pipe(fd_store);
+}
+
 static int
 sys_pgdir(uint64_t arg[]) {
     //print_pgdir();
@@ -69,11 +186,24 @@ static int (*syscalls[])(uint64_t arg[]) = {
     [SYS_fork]              sys_fork,
     [SYS_wait]              sys_wait,
     [SYS_exec]              sys_exec,
+    [SYS_clone]             sys_clone,
     [SYS_yield]             sys_yield,
+    [SYS_sleep]             sys_sleep,
     [SYS_kill]              sys_kill,
+    [SYS_gettime]           sys_gettime,
     [SYS_getpid]            sys_getpid,
+    [SYS_futex]             sys_futex,
+    [SYS_call]              sys_call,
+    [SYS_reply_wait]        sys_reply_wait,
     [SYS_putc]              sys_putc,
     [SYS_pgdir]             sys_pgdir,
+    [SYS_puts]              sys_puts,
+    [SYS_perf_open]         sys_perf_open,
+    [SYS_perf_read]         sys_perf_read,
+    [SYS_close]             sys_close,
+    [SYS_read]              sys_read,
+    [SYS_write]             sys_write,
+    [SYS_pipe]              sys_pipe,
 };
 
 #define NUM_SYSCALLS        ((sizeof(syscalls)) / (sizeof(syscalls[0])))
@@ -90,7 +220,9 @@ syscall(void) {
             arg[2] = tf->gpr.a3;
             arg[3] = tf->gpr.a4;
             arg[4] = tf->gpr.a5;
+            trace(TRACE_SYSCALL, num, arg[0]);
             tf->gpr.a0 = syscalls[num](arg);
+            trace(TRACE_SYSRET, num, tf->gpr.a0);
             return ;
         }
     }
@@ -15,17 +15,22 @@
 #include <sched.h>
 #include <sync.h>
 #include <sbi.h>
+#include <picirq.h>
+#include <smp.h>
+#include <klog.h>
+#include <profile.h>
+#include <trace.h>
 
 #define TICK_NUM 100
 
+#ifdef DEBUG_GRADE
 static void print_ticks()
 {
-    cprintf("%d ticks\n", TICK_NUM);
-#ifdef DEBUG_GRADE
-    cprintf("End of Test.\n");
+    klog(KLOG_INFO, "%d ticks\n", TICK_NUM);
+    klog(KLOG_INFO, "End of Test.\n");
     panic("EOT: kernel seems ok.");
-#endif
 }
+#endif
 
 /* idt_init - initialize IDT to each of the entry points in kern/trap/vectors.S */
 void idt_init(void)
@@ -104,7 +109,8 @@ void interrupt_handler(struct trapframe *tf)
         cprintf("User software interrupt\n");
         break;
     case IRQ_S_SOFT:
-        cprintf("Supervisor software interrupt\n");
+        // an IPI from another hart: it queued work for us, schedule() sees it on the way out
+        clear_csr(sip, SIP_SSIP);
         break;
     case IRQ_H_SOFT:
         cprintf("Hypervisor software interrupt\n");
@@ -123,12 +129,18 @@ void interrupt_handler(struct trapframe *tf)
         *(3) 每 TICK_NUM 次中断（如 100 次），进行判断当前是否有进程正在运行，如果有则标记该进程需要被重新调度（current->need_resched）
         */
         clock_set_next_event(); // (1) 设置下一次时钟中断
-        ticks++; // (2) ticks 计数器自增
-        if (ticks % TICK_NUM == 0) { // (3) 每 TICK_NUM 次中断
-            print_ticks(); // 打印当前 ticks
-            if (current != NULL) {
-                current->need_resched = 1; // 标记当前进程需要重新调度
+        profile_tick(tf); // 采样被打断的 pc
+        if (mycpu() == &cpus[0]) { // 全局 ticks 与定时器只由启动 hart 推进
+            ticks++; // (2) ticks 计数器自增
+            run_timer_list(); // 唤醒到期的定时器
+#ifdef DEBUG_GRADE
+            if (ticks % TICK_NUM == 0) {
+                print_ticks(); // 评测时打印 ticks 并结束
             }
+#endif
+        }
+        if (++mycpu()->ticks % TICK_NUM == 0) { // (3) 每个 hart 每 TICK_NUM 次中断
+            set_need_resched(); // 标记当前进程需要重新调度
         }
         break;
     case IRQ_H_TIMER:
@@ -141,7 +153,7 @@ void interrupt_handler(struct trapframe *tf)
         cprintf("User software interrupt\n");
         break;
     case IRQ_S_EXT:
-        cprintf("Supervisor external interrupt\n");
+        pic_dispatch();
         break;
     case IRQ_H_EXT:
         cprintf("Hypervisor software interrupt\n");
@@ -170,11 +182,13 @@ void exception_handler(struct trapframe *tf)
         cprintf("Illegal instruction\n");
         break;
     case CAUSE_BREAKPOINT:
-        cprintf("Breakpoint\n");
+        klog(KLOG_INFO, "Breakpoint\n");
         if (tf->gpr.a7 == 10)
         {
             tf->epc += 4;
             syscall();
+            // straight back to user mode, bypassing the end of trap()
+            kernel_unlock();
             kernel_execve_ret(tf, current->kstack + KSTACKSIZE);
         }
         break;
@@ -193,7 +207,10 @@ void exception_handler(struct trapframe *tf)
     case CAUSE_USER_ECALL:
         // cprintf("Environment call from U-mode\n");
         tf->epc += 4;
+        // 系统调用期间打开中断，使内核可以被抢占
+        intr_enable();
         syscall();
+        intr_disable();
         break;
     case CAUSE_SUPERVISOR_ECALL:
         cprintf("Environment call from S-mode\n");
@@ -235,6 +252,21 @@ static inline void trap_dispatch(struct trapframe *tf)
     }
 }
 
+// in_interrupt - are we running an interrupt handler rather than on behalf of a process?
+bool in_interrupt(void)
+{
+    return mycpu()->irq_nesting != 0;
+}
+
+static inline void
+trap_dispatch_irq(struct trapframe *tf)
+{
+    bool irq = ((intptr_t)tf->cause < 0);
+    mycpu()->irq_nesting += irq;
+    trap_dispatch(tf);
+    mycpu()->irq_nesting -= irq;
+}
+
 /* *
  * trap - handles or dispatches an exception/interrupt. if and when trap() returns,
  * the code in kern/trap/trapentry.S restores the old CPU state saved in the
@@ -242,11 +274,15 @@ static inline void trap_dispatch(struct trapframe *tf)
  * */
 void trap(struct trapframe *tf)
 {
+    // from user mode we do not hold the kernel lock yet; we give it back
+    // when we return there, possibly as another process or on another hart
+    bool locked = kernel_lock_enter();
+    trace(TRACE_TRAP, tf->cause, tf->epc);
     // dispatch based on what type of trap occurred
     //    cputs("some trap");
     if (current == NULL)
     {
-        trap_dispatch(tf);
+        trap_dispatch_irq(tf);
     }
     else
     {
@@ -255,7 +291,7 @@ void trap(struct trapframe *tf)
 
         bool in_kernel = trap_in_kernel(tf);
 
-        trap_dispatch(tf);
+        trap_dispatch_irq(tf);
 
         current->tf = otf;
         if (!in_kernel)
@@ -269,5 +305,14 @@ void trap(struct trapframe *tf)
                 schedule();
             }
         }
+        else if ((intptr_t)tf->cause < 0 && (tf->status & SSTATUS_SPIE))
+        {
+            // 内核态被中断打断：不在原子区时同样可以抢占
+            preempt_schedule_irq();
+        }
+    }
+    if (locked)
+    {
+        kernel_unlock();
     }
 }
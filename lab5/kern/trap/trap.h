@@ -53,5 +53,6 @@ void idt_init(void);
 void print_trapframe(struct trapframe *tf);
 void print_regs(struct pushregs *gpr);
 bool trap_in_kernel(struct trapframe *tf);
+bool in_interrupt(void);
 
 #endif /* !__KERN_TRAP_TRAP_H__ */
@@ -106,4 +106,90 @@ static inline bool test_and_clear_bit(int nr, volatile void *addr) {
     return __test_and_op_bit(and, __NOT, nr, ((volatile unsigned long *)addr));
 }
 
+/* *
+ * atomic_t - an int that is only read and written through the functions
+ * below, which are safe against other harts. The read-modify-write ones
+ * are full barriers (.aqrl), like their Linux counterparts that return a
+ * value.
+ * */
+typedef struct {
+    volatile int counter;
+} atomic_t;
+
+#define ATOMIC_INIT(i) { (i) }
+
+static inline int atomic_read(const atomic_t *v) {
+    return v->counter;
+}
+
+static inline void atomic_set(atomic_t *v, int i) {
+    v->counter = i;
+}
+
+/* atomic_fetch_add - add @i to @v and return the old value */
+static inline int atomic_fetch_add(atomic_t *v, int i) {
+    int old;
+    __asm__ __volatile__("amoadd.w.aqrl %0, %2, %1"
+                         : "=r"(old), "+A"(v->counter)
+                         : "r"(i)
+                         : "memory");
+    return old;
+}
+
+/* atomic_add_return - add @i to @v and return the new value */
+static inline int atomic_add_return(atomic_t *v, int i) {
+    return atomic_fetch_add(v, i) + i;
+}
+
+static inline int atomic_sub_return(atomic_t *v, int i) {
+    return atomic_fetch_add(v, -i) - i;
+}
+
+/* atomic_add - add @i to @v, without ordering the accesses around it */
+static inline void atomic_add(atomic_t *v, int i) {
+    __asm__ __volatile__("amoadd.w zero, %1, %0" : "+A"(v->counter) : "r"(i));
+}
+
+static inline void atomic_inc(atomic_t *v) {
+    atomic_add(v, 1);
+}
+
+static inline void atomic_dec(atomic_t *v) {
+    atomic_add(v, -1);
+}
+
+/* atomic_dec_and_test - decrement @v and return true if it dropped to 0 */
+static inline bool atomic_dec_and_test(atomic_t *v) {
+    return atomic_sub_return(v, 1) == 0;
+}
+
+/* atomic_xchg - store @i in @v and return the old value */
+static inline int atomic_xchg(atomic_t *v, int i) {
+    int old;
+    __asm__ __volatile__("amoswap.w.aqrl %0, %2, %1"
+                         : "=r"(old), "+A"(v->counter)
+                         : "r"(i)
+                         : "memory");
+    return old;
+}
+
+/* *
+ * atomic_cmpxchg - if @v holds @old, replace it with @new. Returns what
+ * @v held, so the exchange happened iff the result equals @old. There is
+ * no AMO for this, it is an LR/SC loop.
+ * */
+static inline int atomic_cmpxchg(atomic_t *v, int old, int new) {
+    int prev, rc;
+    __asm__ __volatile__(
+        "0: lr.w.aqrl %0, %2\n"
+        "   bne %0, %3, 1f\n"
+        "   sc.w.aqrl %1, %4, %2\n"
+        "   bnez %1, 0b\n"
+        "1:\n"
+        : "=&r"(prev), "=&r"(rc), "+A"(v->counter)
+        : "r"(old), "r"(new)
+        : "memory");
+    return prev;
+}
+
 #endif /* !__LIBS_ATOMIC_H__ */
@@ -5,8 +5,9 @@
 #include <string.h>
 
 /* *
- * Space or zero padding and a field width are supported for the numeric
- * formats only.
+ * A field width with space or zero padding, or left justification ('-'),
+ * is supported for the numeric and string formats; precision only limits
+ * the length of strings.
  *
  * The special format %e takes an integer error code
  * and prints a string describing the error.
@@ -25,39 +26,150 @@ static const char * const error_string[MAXERROR + 1] = {
     [E_INVAL_ELF]           "invalid elf file",
     [E_KILLED]              "process is killed",
     [E_PANIC]               "panic failure",
+    [E_TIMEOUT]             "timeout",
+    [E_AGAIN]               "try again",
+    [E_PIPE]                "broken pipe",
 };
 
 /* *
- * printnum - print a number (base <= 16) in reverse order
- * @putch:      specified putch function, print a single character
- * @putdat:     used by @putch function
- * @num:        the number will be printed
- * @base:       base for print, must be in [1, 16]
- * @width:      maximum number of digits, if the actual width is less than @width, use @padc instead
- * @padc:       character that padded on the left if the actual width is less than @width
+ * Output goes through a struct printbuf (see stdio.h): characters collect
+ * in the caller's buffer and reach the sink in bulk, when the buffer is
+ * full or on printbuf_flush. Without a sink the buffer is a plain string
+ * that silently truncates.
+ * */
+void
+printbuf_init(struct printbuf *pb, char *buf, size_t size,
+              void (*write)(void *data, const char *s, size_t len), void *data) {
+    pb->buf = buf;
+    pb->size = size;
+    pb->len = 0;
+    pb->cnt = 0;
+    pb->write = write;
+    pb->data = data;
+}
+
+/* printbuf_flush - hand everything pending in @pb to its sink */
+void
+printbuf_flush(struct printbuf *pb) {
+    if (pb->write != NULL && pb->len > 0) {
+        pb->write(pb->data, pb->buf, pb->len);
+        pb->len = 0;
+    }
+}
+
+static void
+pb_write(struct printbuf *pb, const char *s, size_t n) {
+    pb->cnt += n;
+    while (n > 0) {
+        if (pb->len == pb->size) {
+            if (pb->write == NULL) {
+                return;
+            }
+            printbuf_flush(pb);
+        }
+        size_t k = pb->size - pb->len;
+        k = (n < k) ? n : k;
+        memcpy(pb->buf + pb->len, s, k);
+        pb->len += k, s += k, n -= k;
+    }
+}
+
+static inline void
+pb_putc(struct printbuf *pb, char c) {
+    if (pb->len < pb->size) {
+        pb->buf[pb->len ++] = c;
+        pb->cnt ++;
+    } else {
+        pb_write(pb, &c, 1);
+    }
+}
+
+static void
+pb_pad(struct printbuf *pb, char c, int n) {
+    while (n -- > 0) {
+        pb_putc(pb, c);
+    }
+}
+
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* *
+ * format_uint - render @num in @base (8, 10 or 16) backwards, ending at
+ * @end; returns where the digits start. Decimal takes two digits per
+ * division from a table, the others are plain shifts.
+ * */
+static char *
+format_uint(char *end, unsigned long long num, unsigned base) {
+    char *p = end;
+    if (base == 10) {
+        while (num >= 100) {
+            unsigned mod = do_div(num, 100);
+            p -= 2;
+            p[0] = digit_pairs[mod * 2], p[1] = digit_pairs[mod * 2 + 1];
+        }
+        if (num >= 10) {
+            p -= 2;
+            p[0] = digit_pairs[num * 2], p[1] = digit_pairs[num * 2 + 1];
+        } else {
+            *-- p = '0' + num;
+        }
+    } else {
+        unsigned shift = (base == 16) ? 4 : 3;
+        do {
+            *-- p = "0123456789abcdef"[num & (base - 1)];
+            num >>= shift;
+        } while (num != 0);
+    }
+    return p;
+}
+
+/* *
+ * printnum - print a number with an optional sign or prefix
+ * @width:      minimum field width, filled with @padc ('-' pads on the right)
  * */
 static void
-printnum(void (*putch)(int, void*), void *putdat,
-        unsigned long long num, unsigned base, int width, int padc) {
-    unsigned long long result = num;
-    unsigned mod = do_div(result, base);
-
-    // first recursively print all preceding (more significant) digits
-    if (num >= base) {
-        printnum(putch, putdat, result, base, width - 1, padc);
+printnum(struct printbuf *pb, unsigned long long num, unsigned base,
+         const char *prefix, int width, char padc) {
+    char tmp[24], *end = tmp + sizeof(tmp);
+    char *p = format_uint(end, num, base);
+    int plen = strlen(prefix), len = (end - p) + plen;
+    if (padc == ' ') {
+        pb_pad(pb, ' ', width - len);
+    }
+    pb_write(pb, prefix, plen);
+    if (padc == '0') {
+        pb_pad(pb, '0', width - len);
+    }
+    pb_write(pb, p, end - p);
+    if (padc == '-') {
+        pb_pad(pb, ' ', width - len);
+    }
+}
+
+/* printstr - print @p, at most @precision characters of it if that is not negative */
+static void
+printstr(struct printbuf *pb, const char *p, int width, int precision, char padc, int altflag) {
+    if (p == NULL) {
+        p = "(null)";
+    }
+    int len = strnlen(p, (precision < 0) ? (size_t)-1 : (size_t)precision);
+    if (padc != '-') {
+        pb_pad(pb, ' ', width - len);
+    }
+    if (!altflag) {
+        pb_write(pb, p, len);
     } else {
-        // print any needed pad characters before first digit
-        while (-- width > 0)
-            putch(padc, putdat);
+        int i;
+        for (i = 0; i < len; i ++) {
+            pb_putc(pb, (p[i] < ' ' || p[i] > '~') ? '?' : p[i]);
+        }
+    }
+    if (padc == '-') {
+        pb_pad(pb, ' ', width - len);
     }
-    // then print this (the least significant) digit
-    putch("0123456789abcdef"[mod], putdat);
-
-    // Crashes if num >= base. No idea what going on here
-    // Here is a quick fix
-    // update: Stack grows downward and destory the SBI
-    // sbi_console_putchar("0123456789abcdef"[mod]);
-    // (*(int *)putdat)++;
 }
 
 /* *
@@ -97,44 +209,54 @@ getint(va_list *ap, int lflag) {
 }
 
 /* *
- * printfmt - format a string and print it by using putch
- * @putch:      specified putch function, print a single character
- * @putdat:     used by @putch function
- * @fmt:        the format string to use
- * */
-void
-printfmt(void (*putch)(int, void*), void *putdat, const char *fmt, ...) {
-    va_list ap;
-
-    va_start(ap, fmt);
-    vprintfmt(putch, putdat, fmt, ap);
-    va_end(ap);
-}
-
-/* *
- * vprintfmt - format a string and print it by using putch, it's called with a va_list
- * instead of a variable number of arguments
- * @putch:      specified putch function, print a single character
- * @putdat:     used by @putch function
- * @fmt:        the format string to use
- * @ap:         arguments for the format string
- *
- * Call this function if you are already dealing with a va_list.
- * Or you probably want printfmt() instead.
+ * vprintbuf - format a string into @pb, it's called with a va_list.
+ * Literal text is copied in runs; a conversion with no flags, width or
+ * length modifier (the common %d, %u, %x, %s, %c) skips the flag parser.
+ * The caller flushes @pb when it is done.
  * */
 void
-vprintfmt(void (*putch)(int, void*), void *putdat, const char *fmt, va_list ap) {
+vprintbuf(struct printbuf *pb, const char *fmt, va_list ap) {
     register const char *p;
     register int ch, err;
     unsigned long long num;
     int base, width, precision, lflag, altflag;
+    const char *prefix;
 
     while (1) {
-        while ((ch = *(unsigned char *)fmt ++) != '%') {
-            if (ch == '\0') {
-                return;
-            }
-            putch(ch, putdat);
+        for (p = fmt; *p != '%' && *p != '\0'; p ++)
+            /* do nothing */;
+        if (p != fmt) {
+            pb_write(pb, fmt, p - fmt);
+        }
+        if (*p == '\0') {
+            return;
+        }
+        fmt = p + 1;
+
+        // fast path: a bare conversion
+        switch (*fmt) {
+        case 'd':
+            fmt ++;
+            num = va_arg(ap, int);
+            printnum(pb, ((long long)num < 0) ? -(long long)num : num, 10,
+                     ((long long)num < 0) ? "-" : "", 0, ' ');
+            continue;
+        case 'u':
+            fmt ++;
+            printnum(pb, va_arg(ap, unsigned int), 10, "", 0, ' ');
+            continue;
+        case 'x':
+            fmt ++;
+            printnum(pb, va_arg(ap, unsigned int), 16, "", 0, ' ');
+            continue;
+        case 's':
+            fmt ++;
+            printstr(pb, va_arg(ap, char *), 0, -1, ' ', 0);
+            continue;
+        case 'c':
+            fmt ++;
+            pb_putc(pb, va_arg(ap, int));
+            continue;
         }
 
         // Process a %-escape sequence
@@ -152,7 +274,9 @@ vprintfmt(void (*putch)(int, void*), void *putdat, const char *fmt, va_list ap)
 
         // flag to pad with 0's instead of spaces
         case '0':
-            padc = '0';
+            if (padc != '-') {
+                padc = '0';
+            }
             goto reswitch;
 
         // width field
@@ -191,7 +315,7 @@ vprintfmt(void (*putch)(int, void*), void *putdat, const char *fmt, va_list ap)
 
         // character
         case 'c':
-            putch(va_arg(ap, int), putdat);
+            pb_putc(pb, va_arg(ap, int));
             break;
 
         // error message
@@ -201,41 +325,25 @@ vprintfmt(void (*putch)(int, void*), void *putdat, const char *fmt, va_list ap)
                 err = -err;
             }
             if (err > MAXERROR || (p = error_string[err]) == NULL) {
-                printfmt(putch, putdat, "error %d", err);
+                pb_write(pb, "error ", 6);
+                printnum(pb, err, 10, "", 0, ' ');
             }
             else {
-                printfmt(putch, putdat, "%s", p);
+                printstr(pb, p, 0, -1, ' ', 0);
             }
             break;
 
         // string
         case 's':
-            if ((p = va_arg(ap, char *)) == NULL) {
-                p = "(null)";
-            }
-            if (width > 0 && padc != '-') {
-                for (width -= strnlen(p, precision); width > 0; width --) {
-                    putch(padc, putdat);
-                }
-            }
-            for (; (ch = *p ++) != '\0' && (precision < 0 || -- precision >= 0); width --) {
-                if (altflag && (ch < ' ' || ch > '~')) {
-                    putch('?', putdat);
-                }
-                else {
-                    putch(ch, putdat);
-                }
-            }
-            for (; width > 0; width --) {
-                putch(' ', putdat);
-            }
+            printstr(pb, va_arg(ap, char *), width, precision, padc, altflag);
             break;
 
         // (signed) decimal
         case 'd':
             num = getint(&ap, lflag);
+            prefix = "";
             if ((long long)num < 0) {
-                putch('-', putdat);
+                prefix = "-";
                 num = -(long long)num;
             }
             base = 10;
@@ -244,39 +352,37 @@ vprintfmt(void (*putch)(int, void*), void *putdat, const char *fmt, va_list ap)
         // unsigned decimal
         case 'u':
             num = getuint(&ap, lflag);
-            base = 10;
+            base = 10, prefix = "";
             goto number;
 
         // (unsigned) octal
         case 'o':
             num = getuint(&ap, lflag);
-            base = 8;
+            base = 8, prefix = "";
             goto number;
 
         // pointer
         case 'p':
-            putch('0', putdat);
-            putch('x', putdat);
             num = (unsigned long long)(uintptr_t)va_arg(ap, void *);
-            base = 16;
+            base = 16, prefix = "0x";
             goto number;
 
         // (unsigned) hexadecimal
         case 'x':
             num = getuint(&ap, lflag);
-            base = 16;
+            base = 16, prefix = "";
         number:
-            printnum(putch, putdat, num, base, width, padc);
+            printnum(pb, num, base, prefix, width, padc);
             break;
 
         // escaped '%' character
         case '%':
-            putch(ch, putdat);
+            pb_putc(pb, ch);
             break;
 
         // unrecognized escape sequence - just print it literally
         default:
-            putch('%', putdat);
+            pb_putc(pb, '%');
             for (fmt --; fmt[-1] != '%'; fmt --)
                 /* do nothing */;
             break;
@@ -284,26 +390,57 @@ vprintfmt(void (*putch)(int, void*), void *putdat, const char *fmt, va_list ap)
     }
 }
 
-/* sprintbuf is used to save enough information of a buffer */
-struct sprintbuf {
-    char *buf;          // address pointer points to the first unused memory
-    char *ebuf;         // points the end of the buffer
-    int cnt;            // the number of characters that have been placed in this buffer
+/* putchsink - the sink of the printbufs behind (v)printfmt: one putch call per character */
+struct putchsink {
+    void (*putch)(int, void *);
+    void *putdat;
 };
 
-/* *
- * sprintputch - 'print' a single character in a buffer
- * @ch:         the character will be printed
- * @b:          the buffer to place the character @ch
- * */
 static void
-sprintputch(int ch, struct sprintbuf *b) {
-    b->cnt ++;
-    if (b->buf < b->ebuf) {
-        *b->buf ++ = ch;
+putchsink_write(void *data, const char *s, size_t len) {
+    struct putchsink *sink = data;
+    while (len -- > 0) {
+        sink->putch((unsigned char)*s ++, sink->putdat);
     }
 }
 
+/* *
+ * printfmt - format a string and print it by using putch
+ * @putch:      specified putch function, print a single character
+ * @putdat:     used by @putch function
+ * @fmt:        the format string to use
+ * */
+void
+printfmt(void (*putch)(int, void*), void *putdat, const char *fmt, ...) {
+    va_list ap;
+
+    va_start(ap, fmt);
+    vprintfmt(putch, putdat, fmt, ap);
+    va_end(ap);
+}
+
+/* *
+ * vprintfmt - format a string and print it by using putch, it's called with a va_list
+ * instead of a variable number of arguments
+ * @putch:      specified putch function, print a single character
+ * @putdat:     used by @putch function
+ * @fmt:        the format string to use
+ * @ap:         arguments for the format string
+ *
+ * Call this function if you are already dealing with a va_list.
+ * Or you probably want printfmt() instead. Output that can be taken in
+ * bulk is better written through vprintbuf.
+ * */
+void
+vprintfmt(void (*putch)(int, void*), void *putdat, const char *fmt, va_list ap) {
+    char buf[64];
+    struct printbuf pb;
+    struct putchsink sink = {putch, putdat};
+    printbuf_init(&pb, buf, sizeof(buf), putchsink_write, &sink);
+    vprintbuf(&pb, fmt, ap);
+    printbuf_flush(&pb);
+}
+
 /* *
  * snprintf - format a string and place it in a buffer
  * @str:        the buffer to place the result into
@@ -336,14 +473,14 @@ snprintf(char *str, size_t size, const char *fmt, ...) {
  * */
 int
 vsnprintf(char *str, size_t size, const char *fmt, va_list ap) {
-    struct sprintbuf b = {str, str + size - 1, 0};
-    if (str == NULL || b.buf > b.ebuf) {
+    struct printbuf pb;
+    if (str == NULL || size == 0) {
         return -E_INVAL;
     }
-    // print the string to the buffer
-    vprintfmt((void*)sprintputch, &b, fmt, ap);
+    // no sink: the string itself is the buffer, what does not fit is dropped
+    printbuf_init(&pb, str, size - 1, NULL, NULL);
+    vprintbuf(&pb, fmt, ap);
     // null terminate the buffer
-    *b.buf = '\0';
-    return b.cnt;
+    str[pb.len] = '\0';
+    return pb.cnt;
 }
-
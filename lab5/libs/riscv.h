@@ -823,6 +823,8 @@ lsatp(unsigned long pgdir)
 #define CSR_SCAUSE 0x142
 #define CSR_STVAL 0x143
 #define CSR_SIP 0x144
+#define CSR_STIMECMP 0x14d
+#define CSR_STIMECMPH 0x15d
 #define CSR_SATP 0x180
 #define CSR_MSTATUS 0x300
 #define CSR_MISA 0x301
@@ -26,6 +26,101 @@
 #define SBI_REMOTE_SFENCE_VMA_ASID 7
 #define SBI_SHUTDOWN 8
 
+/* SBI v0.2+ extension IDs (a7) */
+#define SBI_EXT_BASE 0x10
+#define SBI_EXT_TIME 0x54494D45
+#define SBI_EXT_IPI 0x735049
+#define SBI_EXT_RFENCE 0x52464E43
+#define SBI_EXT_HSM 0x48534D
+#define SBI_EXT_SRST 0x53525354
+#define SBI_EXT_PMU 0x504D55
+#define SBI_EXT_DBCN 0x4442434E
+
+/* SBI_EXT_BASE function IDs (a6) */
+#define SBI_EXT_BASE_GET_SPEC_VERSION 0
+#define SBI_EXT_BASE_GET_IMPL_ID 1
+#define SBI_EXT_BASE_GET_IMPL_VERSION 2
+#define SBI_EXT_BASE_PROBE_EXT 3
+
+/* SBI_EXT_IPI function IDs (a6) */
+#define SBI_EXT_IPI_SEND_IPI 0
+
+/* SBI_EXT_RFENCE function IDs (a6) */
+#define SBI_EXT_RFENCE_REMOTE_SFENCE_VMA 1
+
+/* SBI_EXT_HSM function IDs (a6) */
+#define SBI_EXT_HSM_HART_START 0
+#define SBI_EXT_HSM_HART_STOP 1
+#define SBI_EXT_HSM_HART_GET_STATUS 2
+
+/* SBI_EXT_HSM_HART_GET_STATUS states */
+#define SBI_HSM_STATE_STARTED 0
+#define SBI_HSM_STATE_STOPPED 1
+#define SBI_HSM_STATE_START_PENDING 2
+#define SBI_HSM_STATE_STOP_PENDING 3
+
+/* SBI_EXT_PMU function IDs (a6) */
+#define SBI_EXT_PMU_NUM_COUNTERS 0
+#define SBI_EXT_PMU_COUNTER_GET_INFO 1
+#define SBI_EXT_PMU_COUNTER_CFG_MATCH 2
+#define SBI_EXT_PMU_COUNTER_START 3
+#define SBI_EXT_PMU_COUNTER_STOP 4
+#define SBI_EXT_PMU_COUNTER_FW_READ 5
+
+/* SBI_EXT_PMU_COUNTER_GET_INFO value: CSR number, width - 1, firmware counter */
+#define SBI_PMU_INFO_CSR(info) ((info) & 0xfff)
+#define SBI_PMU_INFO_WIDTH(info) ((((info) >> 12) & 0x3f) + 1)
+#define SBI_PMU_INFO_FW(info) ((unsigned long)(info) >> (__riscv_xlen - 1))
+
+/* SBI_EXT_PMU_COUNTER_CFG_MATCH config flags */
+#define SBI_PMU_CFG_FLAG_SKIP_MATCH (1 << 0)
+#define SBI_PMU_CFG_FLAG_CLEAR_VALUE (1 << 1)
+#define SBI_PMU_CFG_FLAG_AUTO_START (1 << 2)
+#define SBI_PMU_CFG_FLAG_SET_MINH (1 << 7)
+
+/* SBI_EXT_PMU_COUNTER_STOP flags */
+#define SBI_PMU_STOP_FLAG_RESET (1 << 0)
+
+/* SBI PMU event_idx: type in bits 19:16, code below */
+#define SBI_PMU_EVENT_HW(code) (code)
+#define SBI_PMU_EVENT_CACHE(cache, op, result) \
+	((1 << 16) | ((cache) << 3) | ((op) << 1) | (result))
+
+#define SBI_PMU_HW_CPU_CYCLES 1
+#define SBI_PMU_HW_INSTRUCTIONS 2
+#define SBI_PMU_HW_CACHE_REFERENCES 3
+#define SBI_PMU_HW_CACHE_MISSES 4
+#define SBI_PMU_HW_BRANCH_MISSES 6
+
+#define SBI_PMU_CACHE_L1D 0
+#define SBI_PMU_CACHE_L1I 1
+#define SBI_PMU_CACHE_LL 2
+#define SBI_PMU_CACHE_DTLB 3
+#define SBI_PMU_CACHE_ITLB 4
+#define SBI_PMU_CACHE_OP_READ 0
+#define SBI_PMU_CACHE_RESULT_ACCESS 0
+#define SBI_PMU_CACHE_RESULT_MISS 1
+
+/* SBI_EXT_DBCN function IDs (a6) */
+#define SBI_EXT_DBCN_CONSOLE_WRITE 0
+#define SBI_EXT_DBCN_CONSOLE_READ 1
+#define SBI_EXT_DBCN_CONSOLE_WRITE_BYTE 2
+
+/* SBI v0.2+ error codes */
+#define SBI_SUCCESS 0
+#define SBI_ERR_FAILED -1
+#define SBI_ERR_NOT_SUPPORTED -2
+#define SBI_ERR_INVALID_PARAM -3
+#define SBI_ERR_DENIED -4
+#define SBI_ERR_INVALID_ADDRESS -5
+#define SBI_ERR_ALREADY_AVAILABLE -6
+#define SBI_ERR_ALREADY_STARTED -7
+#define SBI_ERR_ALREADY_STOPPED -8
+
+#define SBI_SPEC_VERSION_MAJOR_SHIFT 24
+#define SBI_SPEC_VERSION_MAJOR_MASK 0x7f
+#define SBI_SPEC_VERSION_MINOR_MASK 0xffffff
+
 #define SBI_CALL(which, arg0, arg1, arg2) ({			\
 	register uintptr_t a0 asm ("a0") = (uintptr_t)(arg0);	\
 	register uintptr_t a1 asm ("a1") = (uintptr_t)(arg1);	\
@@ -38,6 +133,35 @@
 	a0;							\
 })
 
+/* value pair returned in a0/a1 by every SBI v0.2+ call */
+struct sbiret {
+	long error;
+	long value;
+};
+
+static inline struct sbiret sbi_ecall(unsigned long ext, unsigned long fid,
+				      unsigned long arg0, unsigned long arg1,
+				      unsigned long arg2, unsigned long arg3,
+				      unsigned long arg4, unsigned long arg5)
+{
+	struct sbiret ret;
+	register uintptr_t a0 asm ("a0") = (uintptr_t)(arg0);
+	register uintptr_t a1 asm ("a1") = (uintptr_t)(arg1);
+	register uintptr_t a2 asm ("a2") = (uintptr_t)(arg2);
+	register uintptr_t a3 asm ("a3") = (uintptr_t)(arg3);
+	register uintptr_t a4 asm ("a4") = (uintptr_t)(arg4);
+	register uintptr_t a5 asm ("a5") = (uintptr_t)(arg5);
+	register uintptr_t a6 asm ("a6") = (uintptr_t)(fid);
+	register uintptr_t a7 asm ("a7") = (uintptr_t)(ext);
+	asm volatile ("ecall"
+		      : "+r" (a0), "+r" (a1)
+		      : "r" (a2), "r" (a3), "r" (a4), "r" (a5), "r" (a6), "r" (a7)
+		      : "memory");
+	ret.error = a0;
+	ret.value = a1;
+	return ret;
+}
+
 /* Lazy implementations until SBI is finalized */
 #define SBI_CALL_0(which) SBI_CALL(which, 0, 0, 0)
 #define SBI_CALL_1(which, arg0) SBI_CALL(which, arg0, 0, 0)
@@ -97,4 +221,123 @@ static inline void sbi_remote_sfence_vma_asid(const unsigned long *hart_mask,
 	SBI_CALL_1(SBI_REMOTE_SFENCE_VMA_ASID, hart_mask);
 }
 
+/* *
+ * sbi_get_spec_version - return the SBI spec version implemented by the
+ * firmware, or 0 if it only speaks the legacy v0.1 interface (which has no
+ * base extension and answers every v0.2 call with SBI_ERR_NOT_SUPPORTED).
+ * */
+static inline long sbi_get_spec_version(void)
+{
+	struct sbiret ret = sbi_ecall(SBI_EXT_BASE,
+				      SBI_EXT_BASE_GET_SPEC_VERSION,
+				      0, 0, 0, 0, 0, 0);
+	return (ret.error == SBI_SUCCESS) ? ret.value : 0;
+}
+
+/* sbi_probe_extension - return non-zero if extension @ext is implemented */
+static inline long sbi_probe_extension(long ext)
+{
+	struct sbiret ret;
+	if (sbi_get_spec_version() == 0)
+		return 0;
+	ret = sbi_ecall(SBI_EXT_BASE, SBI_EXT_BASE_PROBE_EXT,
+			ext, 0, 0, 0, 0, 0);
+	return (ret.error == SBI_SUCCESS) ? ret.value : 0;
+}
+
+/* *
+ * sbi_hart_start - start hart @hartid at physical address @start_addr in
+ * S-mode with the MMU off, a0 = @hartid and a1 = @opaque.
+ * */
+static inline struct sbiret sbi_hart_start(unsigned long hartid,
+					   uintptr_t start_addr,
+					   unsigned long opaque)
+{
+	return sbi_ecall(SBI_EXT_HSM, SBI_EXT_HSM_HART_START,
+			 hartid, start_addr, opaque, 0, 0, 0);
+}
+
+static inline struct sbiret sbi_hart_get_status(unsigned long hartid)
+{
+	return sbi_ecall(SBI_EXT_HSM, SBI_EXT_HSM_HART_GET_STATUS,
+			 hartid, 0, 0, 0, 0, 0);
+}
+
+/* send a supervisor software interrupt to the harts hart_mask_base + i, for each bit i of hart_mask */
+static inline struct sbiret sbi_send_ipi_mask(unsigned long hart_mask,
+					      unsigned long hart_mask_base)
+{
+	return sbi_ecall(SBI_EXT_IPI, SBI_EXT_IPI_SEND_IPI,
+			 hart_mask, hart_mask_base, 0, 0, 0, 0);
+}
+
+static inline struct sbiret sbi_remote_sfence_vma_mask(unsigned long hart_mask,
+						       unsigned long hart_mask_base,
+						       unsigned long start,
+						       unsigned long size)
+{
+	return sbi_ecall(SBI_EXT_RFENCE, SBI_EXT_RFENCE_REMOTE_SFENCE_VMA,
+			 hart_mask, hart_mask_base, start, size, 0, 0);
+}
+
+/* *
+ * sbi_debug_console_write - write @num_bytes bytes at physical address
+ * @base_pa to the debug console in one call. ret.value holds the number
+ * of bytes actually written, which may be less than @num_bytes.
+ * */
+static inline struct sbiret sbi_debug_console_write(unsigned long num_bytes,
+						    uintptr_t base_pa)
+{
+	/* base address is passed as lo/hi halves; hi is 0 for our kernel */
+	return sbi_ecall(SBI_EXT_DBCN, SBI_EXT_DBCN_CONSOLE_WRITE,
+			 num_bytes, base_pa, 0, 0, 0, 0);
+}
+
+static inline struct sbiret sbi_debug_console_write_byte(int ch)
+{
+	return sbi_ecall(SBI_EXT_DBCN, SBI_EXT_DBCN_CONSOLE_WRITE_BYTE,
+			 (unsigned char)ch, 0, 0, 0, 0, 0);
+}
+
+static inline struct sbiret sbi_pmu_num_counters(void)
+{
+	return sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_NUM_COUNTERS,
+			 0, 0, 0, 0, 0, 0);
+}
+
+static inline struct sbiret sbi_pmu_counter_get_info(unsigned long idx)
+{
+	return sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_COUNTER_GET_INFO,
+			 idx, 0, 0, 0, 0, 0);
+}
+
+/* *
+ * sbi_pmu_counter_config_matching - pick a counter among idx_base + i, for
+ * each bit i of @idx_mask, that can count @event_idx and configure it for
+ * that. ret.value holds the index of the counter.
+ * */
+static inline struct sbiret sbi_pmu_counter_config_matching(unsigned long idx_base,
+							   unsigned long idx_mask,
+							   unsigned long flags,
+							   unsigned long event_idx,
+							   uint64_t event_data)
+{
+	return sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_COUNTER_CFG_MATCH,
+			 idx_base, idx_mask, flags, event_idx, event_data, 0);
+}
+
+static inline struct sbiret sbi_pmu_counter_stop(unsigned long idx_base,
+						 unsigned long idx_mask,
+						 unsigned long flags)
+{
+	return sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_COUNTER_STOP,
+			 idx_base, idx_mask, flags, 0, 0, 0);
+}
+
+static inline struct sbiret sbi_pmu_counter_fw_read(unsigned long idx)
+{
+	return sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_COUNTER_FW_READ,
+			 idx, 0, 0, 0, 0, 0);
+}
+
 #endif /* !__SBI_H__ */
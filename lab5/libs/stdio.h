@@ -15,6 +15,25 @@ int getchar(void);
 char *readline(const char *prompt);
 
 /* libs/printfmt.c */
+
+/* *
+ * printbuf - a formatting target: output collects in @buf and is handed
+ * to @write in bulk when @buf is full or on printbuf_flush. With no
+ * @write, @buf is simply filled and the rest is dropped, only counted.
+ * */
+struct printbuf {
+    char *buf;
+    size_t size;
+    size_t len;     // characters pending in buf
+    int cnt;        // characters produced so far
+    void (*write)(void *data, const char *s, size_t len);
+    void *data;
+};
+
+void printbuf_init(struct printbuf *pb, char *buf, size_t size,
+                   void (*write)(void *data, const char *s, size_t len), void *data);
+void printbuf_flush(struct printbuf *pb);
+void vprintbuf(struct printbuf *pb, const char *fmt, va_list ap);
 void printfmt(void (*putch)(int, void *), void *putdat, const char *fmt, ...);
 void vprintfmt(void (*putch)(int, void *), void *putdat, const char *fmt, va_list ap);
 int snprintf(char *str, size_t size, const char *fmt, ...);
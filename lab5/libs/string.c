@@ -258,6 +258,61 @@ strtol(const char *s, char **endptr, int base) {
     return (neg ? -val : val);
 }
 
+/* *
+ * The memory functions below move a machine word at a time, eight words
+ * per loop iteration, once the destination is word-aligned; only the
+ * unaligned head and the tail shorter than a word go byte by byte. Small
+ * requests stay on the byte loops, where the set-up would not pay off.
+ *
+ * GCC may turn the loops back into calls to memset/memcpy, i.e. into
+ * infinite recursion, so loop pattern distribution is off for them.
+ * */
+#define WSIZE sizeof(unsigned long)
+#define WMASK (WSIZE - 1)
+#define WSHORT (2 * WSIZE)
+
+#define __no_libcall __attribute__((optimize("no-tree-loop-distribute-patterns")))
+
+/* *
+ * copy_words - copy @n bytes forward from @s to the word-aligned @d and
+ * return the number left over (less than a word). If @s is not aligned
+ * too, each destination word is merged from the two source words it
+ * straddles, so there are no misaligned loads; they trap on many harts.
+ * Reading a whole aligned word never crosses into the next page, so the
+ * bytes read beyond the source are harmless. Safe for overlapping areas
+ * as long as @d < @s.
+ * */
+static __no_libcall size_t
+copy_words(unsigned char **dp, const unsigned char **sp, size_t n) {
+    unsigned long *d = (unsigned long *)*dp;
+    size_t off = (uintptr_t)*sp & WMASK;
+    if (off == 0) {
+        const unsigned long *s = (const unsigned long *)*sp;
+        for (; n >= 8 * WSIZE; n -= 8 * WSIZE, d += 8, s += 8) {
+            unsigned long w0 = s[0], w1 = s[1], w2 = s[2], w3 = s[3];
+            unsigned long w4 = s[4], w5 = s[5], w6 = s[6], w7 = s[7];
+            d[0] = w0, d[1] = w1, d[2] = w2, d[3] = w3;
+            d[4] = w4, d[5] = w5, d[6] = w6, d[7] = w7;
+        }
+        for (; n >= WSIZE; n -= WSIZE) {
+            *d ++ = *s ++;
+        }
+        *sp = (const unsigned char *)s;
+    } else {
+        const unsigned long *s = (const unsigned long *)(*sp - off);
+        size_t rshift = off * 8, lshift = WSIZE * 8 - rshift;
+        unsigned long lo = *s ++;
+        for (; n >= WSIZE; n -= WSIZE) {
+            unsigned long hi = *s ++;
+            *d ++ = (lo >> rshift) | (hi << lshift);
+            lo = hi;
+        }
+        *sp = (const unsigned char *)s - WSIZE + off;
+    }
+    *dp = (unsigned char *)d;
+    return n;
+}
+
 /* *
  * memset - sets the first @n bytes of the memory area pointed by @s
  * to the specified value @c.
@@ -267,12 +322,26 @@ strtol(const char *s, char **endptr, int base) {
  *
  * The memset() function returns @s.
  * */
-void *
+void * __no_libcall
 memset(void *s, char c, size_t n) {
 #ifdef __HAVE_ARCH_MEMSET
     return __memset(s, c, n);
 #else
-    char *p = s;
+    unsigned char *p = s;
+    if (n >= WSHORT) {
+        for (; ((uintptr_t)p & WMASK) != 0; n --) {
+            *p ++ = c;
+        }
+        unsigned long w = (~0UL / 0xff) * (unsigned char)c, *wp = (unsigned long *)p;
+        for (; n >= 8 * WSIZE; n -= 8 * WSIZE, wp += 8) {
+            wp[0] = w, wp[1] = w, wp[2] = w, wp[3] = w;
+            wp[4] = w, wp[5] = w, wp[6] = w, wp[7] = w;
+        }
+        for (; n >= WSIZE; n -= WSIZE) {
+            *wp ++ = w;
+        }
+        p = (unsigned char *)wp;
+    }
     while (n -- > 0) {
         *p ++ = c;
     }
@@ -289,22 +358,33 @@ memset(void *s, char c, size_t n) {
  *
  * The memmove() function returns @dst.
  * */
-void *
+void * __no_libcall
 memmove(void *dst, const void *src, size_t n) {
 #ifdef __HAVE_ARCH_MEMMOVE
     return __memmove(dst, src, n);
 #else
-    const char *s = src;
-    char *d = dst;
+    const unsigned char *s = src;
+    unsigned char *d = dst;
     if (s < d && s + n > d) {
+        // copy backwards; words only if both ends can be aligned together
         s += n, d += n;
+        if (n >= WSHORT && (((uintptr_t)s ^ (uintptr_t)d) & WMASK) == 0) {
+            for (; ((uintptr_t)d & WMASK) != 0; n --) {
+                *-- d = *-- s;
+            }
+            unsigned long *wd = (unsigned long *)d;
+            const unsigned long *ws = (const unsigned long *)s;
+            for (; n >= WSIZE; n -= WSIZE) {
+                *-- wd = *-- ws;
+            }
+            d = (unsigned char *)wd, s = (const unsigned char *)ws;
+        }
         while (n -- > 0) {
             *-- d = *-- s;
         }
     } else {
-        while (n -- > 0) {
-            *d ++ = *s ++;
-        }
+        // memcpy goes front to back, which is safe when @dst is below @src
+        return memcpy(dst, src, n);
     }
     return dst;
 #endif /* __HAVE_ARCH_MEMMOVE */
@@ -324,13 +404,19 @@ memmove(void *dst, const void *src, size_t n) {
  * by both @src and @dst, should be at least @n bytes, and should not overlap
  * (for overlapping memory area, memmove is a safer approach).
  * */
-void *
+void * __no_libcall
 memcpy(void *dst, const void *src, size_t n) {
 #ifdef __HAVE_ARCH_MEMCPY
     return __memcpy(dst, src, n);
 #else
-    const char *s = src;
-    char *d = dst;
+    const unsigned char *s = src;
+    unsigned char *d = dst;
+    if (n >= WSHORT) {
+        for (; ((uintptr_t)d & WMASK) != 0; n --) {
+            *d ++ = *s ++;
+        }
+        n = copy_words(&d, &s, n);
+    }
     while (n -- > 0) {
         *d ++ = *s ++;
     }
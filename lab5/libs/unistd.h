@@ -18,12 +18,42 @@
 #define SYS_mmap            20
 #define SYS_munmap          21
 #define SYS_shmem           22
+#define SYS_futex           23
+#define SYS_call            24
+#define SYS_reply_wait      25
 #define SYS_putc            30
 #define SYS_pgdir           31
+#define SYS_puts            32
+#define SYS_perf_open       33
+#define SYS_perf_read       34
+#define SYS_close           101
+#define SYS_read            102
+#define SYS_write           103
+#define SYS_pipe            105
 
 /* SYS_fork flags */
 #define CLONE_VM            0x00000100  // set if VM shared between processes
 #define CLONE_THREAD        0x00000200  // thread group
+#define CLONE_FS            0x00000800  // set if shared between processes
+
+/* SYS_call/SYS_reply_wait message size, in registers */
+#define IPC_MSG_WORDS       4
+
+/* SYS_futex operations */
+#define FUTEX_WAIT          0   // sleep if *addr == val
+#define FUTEX_WAKE          1   // wake up to val sleepers on addr
+#define FUTEX_REQUEUE       3   // wake val sleepers, move up to val2 others to addr2
+
+/* SYS_perf_open events, counted per process */
+#define PERF_CYCLES         0
+#define PERF_INSTRUCTIONS   1
+#define PERF_CACHE_REFS     2   // last-level cache references
+#define PERF_CACHE_MISSES   3   // last-level cache misses
+#define PERF_BRANCH_MISSES  4
+#define PERF_L1D_MISSES     5   // L1 data cache read misses
+#define PERF_DTLB_MISSES    6   // data TLB read misses
+#define PERF_ITLB_MISSES    7   // instruction TLB misses
+#define PERF_NR_EVENTS      8
 
 #endif /* !__LIBS_UNISTD_H__ */
 
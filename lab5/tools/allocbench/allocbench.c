@@ -0,0 +1,451 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "host.h"
+
+/* *
+ * allocbench - run the kernel's page managers and kmalloc on the host.
+ *
+ * kern/mm/default_pmm.c and kern/mm/kmalloc.c are compiled as they are for
+ * the host and linked with hostpmm.c, which stands in for kern/mm/pmm.c,
+ * along with the best_fit, buddy and slub managers of lab2.
+ * Every test replays a random trace of allocations and frees, growing and
+ * shrinking its live set in turns, twice:
+ *
+ *  - checked: every page handed out is tracked, blocks are filled with a
+ *    pattern that must still be there when they are freed, and every
+ *    -c ops the free list is walked for broken invariants, which is also
+ *    where fragmentation is sampled. The first problem panics, naming the
+ *    test, seed and operation that hit it.
+ *  - timed: the same trace without any of that, for ns per operation.
+ *
+ * The result is one BENCH line per test, in the format of make bench, so
+ * tools/benchcmp.sh compares two runs. With -f N only the checked run is
+ * done, N times with successive seeds and the free list walked after every
+ * operation. Each test runs in a child process of its own, as kmalloc's
+ * heap cannot be reset.
+ * */
+
+#define PGSIZE          4096
+#define MAX_LIVE        4096
+
+struct test
+{
+    char name[32];
+    int pmm;            // index of the page manager, see host_pmm_name
+    int kmalloc;        // trace kmalloc/kfree on top of it instead of pages
+    int max_live;       // blocks held at most at once
+};
+
+struct block
+{
+    void *ptr;
+    unsigned long size; // pages, or bytes for kmalloc
+    unsigned char tag;
+};
+
+struct stats
+{
+    unsigned long oom;
+    unsigned long frag_nr;
+    double frag_sum, frag_max;
+    unsigned long live, live_peak;      // bytes
+    unsigned long used_peak;            // pages taken from the manager at live_peak
+};
+
+static unsigned long nr_ops = 200000;
+static unsigned long nr_pages = 8192;
+static unsigned long seed = 1;
+static unsigned long rounds = 0;
+static unsigned long check_every = 0;
+
+static struct test tests[8];
+static int nr_tests;
+static struct block blocks[MAX_LIVE];
+
+// where we are, for panic messages
+static const char *cur_test = "setup";
+static unsigned long cur_seed, cur_op;
+
+int cprintf(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int cnt = vprintf(fmt, ap);
+    va_end(ap);
+    return cnt;
+}
+
+void __warn(const char *file, int line, const char *fmt, ...)
+{
+    va_list ap;
+    fprintf(stderr, "allocbench: warning at %s:%d: ", file, line);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fprintf(stderr, "\n");
+}
+
+void __panic(const char *file, int line, const char *fmt, ...)
+{
+    va_list ap;
+    fflush(stdout);
+    fprintf(stderr, "allocbench: panic at %s:%d: ", file, line);
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fprintf(stderr, "\n  test %s, seed %lu, operation %lu\n", cur_test, cur_seed, cur_op);
+    exit(1);
+}
+
+#define check(x, ...)                                       \
+    do {                                                    \
+        if (!(x)) {                                         \
+            __panic(__FILE__, __LINE__, __VA_ARGS__);       \
+        }                                                   \
+    } while (0)
+
+// xorshift64*, so that a seed means the same trace everywhere
+static unsigned long long rnd_state;
+
+static void
+rnd_seed(unsigned long s) {
+    rnd_state = s * 0x9e3779b97f4a7c15ULL + 1;
+}
+
+static unsigned long
+rnd(void) {
+    rnd_state ^= rnd_state >> 12;
+    rnd_state ^= rnd_state << 25;
+    rnd_state ^= rnd_state >> 27;
+    return (rnd_state * 0x2545f4914f6cdd1dULL) >> 32;
+}
+
+static unsigned long
+rnd_range(unsigned long lo, unsigned long hi) {
+    return lo + rnd() % (hi - lo + 1);
+}
+
+// mostly single pages, like page tables and stacks, some larger runs
+static unsigned long
+pmm_size(void) {
+    unsigned long r = rnd() % 100;
+    if (r < 70) {
+        return 1;
+    }
+    if (r < 90) {
+        return rnd_range(2, 8);
+    }
+    if (r < 98) {
+        return rnd_range(9, 64);
+    }
+    return rnd_range(65, 256);
+}
+
+// mostly small objects, a few over a page that take the bigblock path
+static unsigned long
+kmalloc_size(void) {
+    unsigned long r = rnd() % 100;
+    if (r < 50) {
+        return rnd_range(1, 64);
+    }
+    if (r < 80) {
+        return rnd_range(65, 512);
+    }
+    if (r < 95) {
+        return rnd_range(513, PGSIZE - 1);
+    }
+    return rnd_range(4096, 4 * PGSIZE);
+}
+
+static void *
+block_alloc(struct test *t, unsigned long size) {
+    return t->kmalloc ? host_kmalloc(size) : host_alloc_pages(size);
+}
+
+static void
+block_free(struct test *t, struct block *b) {
+    if (t->kmalloc) {
+        host_kfree(b->ptr);
+    }
+    else {
+        host_free_pages(b->ptr, b->size);
+    }
+}
+
+static unsigned char *
+block_mem(struct test *t, struct block *b, unsigned long *len) {
+    if (t->kmalloc) {
+        *len = b->size;
+        return b->ptr;
+    }
+    *len = b->size * PGSIZE;
+    return host_page2kva(b->ptr);
+}
+
+// block_fill - check a new block and give it its pattern
+static void
+block_fill(struct test *t, struct block *b) {
+    unsigned long len;
+    unsigned char *mem = block_mem(t, b, &len);
+    if (t->kmalloc) {
+        // objects of a page or more come straight from alloc_pages
+        unsigned long align = (host_ksize(mem) >= PGSIZE) ? PGSIZE : 8;
+        check(((unsigned long)mem & (align - 1)) == 0, "kmalloc(%lu) returned %p", b->size, mem);
+        check(host_ksize(mem) >= b->size, "ksize %lu < %lu", host_ksize(mem), b->size);
+    }
+    memset(mem, b->tag, len);
+}
+
+// block_verify - a block about to be freed must still hold its pattern
+static void
+block_verify(struct test *t, struct block *b) {
+    unsigned long i, len;
+    unsigned char *mem = block_mem(t, b, &len);
+    for (i = 0; i < len; i++) {
+        check(mem[i] == b->tag, "block %p (size %lu) overwritten at byte %lu", mem, b->size, i);
+    }
+}
+
+static void
+verify(struct test *t, struct stats *st) {
+    unsigned long largest, nr_free = host_nr_free_pages();
+    const char *err = host_pmm_verify(&largest);
+    check(err == NULL, "%s", err);
+    if (largest != 0 && nr_free != 0) {
+        double frag = 1.0 - (double)largest / nr_free;
+        st->frag_sum += frag, st->frag_nr++;
+        if (frag > st->frag_max) {
+            st->frag_max = frag;
+        }
+    }
+}
+
+/* *
+ * run_trace - replay the trace of @s. The live set grows for an eighth of
+ * the operations, then shrinks for the next eighth, and so on; an
+ * allocation that fails is counted and skipped. With @checked, blocks are
+ * checked and the manager is verified every @every operations.
+ * */
+static void
+run_trace(struct test *t, unsigned long s, int checked, unsigned long every, struct stats *st) {
+    unsigned long op, phase = nr_ops / 8 + 1;
+    int nr = 0;
+
+    cur_seed = s;
+    rnd_seed(s);
+    for (op = 0; op < nr_ops; op++) {
+        cur_op = op;
+        int grow = ((op / phase) & 1) == 0;
+        if (nr < t->max_live && (nr == 0 || rnd() % 100 < (grow ? 60 : 40))) {
+            struct block *b = &blocks[nr];
+            b->size = t->kmalloc ? kmalloc_size() : pmm_size();
+            if ((b->ptr = block_alloc(t, b->size)) == NULL) {
+                st->oom++;
+                continue;
+            }
+            nr++;
+            b->tag = (unsigned char)rnd();
+            if (checked) {
+                block_fill(t, b);
+                st->live += t->kmalloc ? b->size : b->size * PGSIZE;
+                if (st->live > st->live_peak) {
+                    st->live_peak = st->live;
+                    st->used_peak = nr_pages - host_nr_free_pages();
+                }
+            }
+        }
+        else {
+            int i = rnd() % nr;
+            if (checked) {
+                block_verify(t, &blocks[i]);
+                st->live -= t->kmalloc ? blocks[i].size : blocks[i].size * PGSIZE;
+            }
+            block_free(t, &blocks[i]);
+            blocks[i] = blocks[--nr];
+        }
+        if (checked && op % every == 0) {
+            verify(t, st);
+        }
+    }
+
+    // free what is left, the pages must all come back
+    cur_op = nr_ops;
+    while (nr > 0) {
+        nr--;
+        if (checked) {
+            block_verify(t, &blocks[nr]);
+            st->live -= t->kmalloc ? blocks[nr].size : blocks[nr].size * PGSIZE;
+        }
+        block_free(t, &blocks[nr]);
+    }
+    if (checked) {
+        unsigned long largest;
+        check(host_pmm_verify(&largest) == NULL, "%s", host_pmm_verify(&largest));
+        if (!t->kmalloc) {
+            check(host_nr_free_pages() == nr_pages, "%lu of %lu pages free after freeing everything",
+                  host_nr_free_pages(), nr_pages);
+            check(largest == 0 || largest == nr_pages, "free memory left in pieces, largest %lu", largest);
+        }
+    }
+}
+
+static void
+select_pmm(struct test *t) {
+    check(host_pmm_select(t->pmm, nr_pages) == 0, "cannot start %s over %lu pages",
+          host_pmm_name(t->pmm), nr_pages);
+}
+
+static double
+now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void
+run_test(struct test *t) {
+    struct stats st;
+    unsigned long r;
+
+    cur_test = t->name;
+    select_pmm(t);
+    host_pmm_track(1);
+    host_pmm_self_check();
+
+    if (rounds != 0) {
+        for (r = 0; r < rounds; r++) {
+            // kmalloc's heap lives on, its pages must stay where they are
+            if (r != 0 && !t->kmalloc) {
+                select_pmm(t);
+            }
+            memset(&st, 0, sizeof(st));
+            run_trace(t, seed + r, 1, check_every ? check_every : 1, &st);
+        }
+        printf("fuzz %s: %lu rounds of %lu operations, no errors\n", t->name, rounds, nr_ops);
+        return;
+    }
+
+    memset(&st, 0, sizeof(st));
+    run_trace(t, seed, 1, check_every ? check_every : 64, &st);
+
+    host_pmm_track(0);
+    if (!t->kmalloc) {
+        select_pmm(t);
+    }
+    struct stats timed;
+    memset(&timed, 0, sizeof(timed));
+    double start = now_ns();
+    run_trace(t, seed, 0, 0, &timed);
+    double ns = (now_ns() - start) / nr_ops;
+
+    if (t->kmalloc) {
+        printf("BENCH %s iters=%lu ns_per_op=%.1f util=%.2f pages_peak=%lu oom=%lu\n", t->name, nr_ops, ns,
+               st.used_peak ? (double)st.live_peak / (st.used_peak * PGSIZE) : 0.0, st.used_peak, st.oom);
+    }
+    else {
+        printf("BENCH %s iters=%lu ns_per_op=%.1f frag_avg=%.2f frag_max=%.2f oom=%lu\n", t->name, nr_ops, ns,
+               st.frag_nr ? st.frag_sum / st.frag_nr : 0.0, st.frag_max, st.oom);
+    }
+}
+
+// one test per page manager, pmm_<name>, and kmalloc over the first one
+static void
+make_tests(void) {
+    int i;
+    for (i = 0; i < host_pmm_count() && nr_tests < 7; i++) {
+        struct test *t = &tests[nr_tests++];
+        const char *name = host_pmm_name(i), *end = strstr(name, "_pmm_manager");
+        int len = end ? end - name : (int)strlen(name);
+        snprintf(t->name, sizeof(t->name), "pmm_%.*s", len, name);
+        t->pmm = i, t->kmalloc = 0, t->max_live = 1024;
+    }
+    struct test *t = &tests[nr_tests++];
+    snprintf(t->name, sizeof(t->name), "kmalloc");
+    t->pmm = 0, t->kmalloc = 1, t->max_live = MAX_LIVE;
+}
+
+static int
+spawn(struct test *t) {
+    int status;
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (pid == 0) {
+        run_test(t);
+        exit(0);
+    }
+    if (waitpid(pid, &status, 0) < 0) {
+        perror("waitpid");
+        return -1;
+    }
+    if (WIFSIGNALED(status)) {
+        fprintf(stderr, "allocbench: %s killed by signal %d\n", t->name, WTERMSIG(status));
+        return -1;
+    }
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : -1;
+}
+
+static void
+usage(void) {
+    int i;
+    fprintf(stderr, "usage: allocbench [-n ops] [-p pages] [-s seed] [-f rounds] [-c every] [test ...]\n"
+                    "  -n  operations per trace (%lu)\n"
+                    "  -p  pages of memory, at most %d (%lu)\n"
+                    "  -s  seed of the first trace (%lu)\n"
+                    "  -f  fuzz: check this many traces, no timing\n"
+                    "  -c  walk the free list every this many operations (64, 1 when fuzzing)\n"
+                    "tests:", nr_ops, HOST_NPAGE_MAX, nr_pages, seed);
+    for (i = 0; i < nr_tests; i++) {
+        fprintf(stderr, " %s", tests[i].name);
+    }
+    fprintf(stderr, "\n");
+    exit(2);
+}
+
+int
+main(int argc, char *argv[]) {
+    int c, i, j, failed = 0;
+
+    make_tests();
+    while ((c = getopt(argc, argv, "n:p:s:f:c:h")) != -1) {
+        switch (c) {
+        case 'n': nr_ops = strtoul(optarg, NULL, 0); break;
+        case 'p': nr_pages = strtoul(optarg, NULL, 0); break;
+        case 's': seed = strtoul(optarg, NULL, 0); break;
+        case 'f': rounds = strtoul(optarg, NULL, 0); break;
+        case 'c': check_every = strtoul(optarg, NULL, 0); break;
+        default: usage();
+        }
+    }
+    if (nr_ops == 0 || nr_pages == 0 || nr_pages > HOST_NPAGE_MAX) {
+        usage();
+    }
+
+    if (optind == argc) {
+        for (i = 0; i < nr_tests; i++) {
+            failed |= spawn(&tests[i]);
+        }
+        return failed ? 1 : 0;
+    }
+    for (j = optind; j < argc; j++) {
+        for (i = 0; i < nr_tests; i++) {
+            if (strcmp(argv[j], tests[i].name) == 0) {
+                break;
+            }
+        }
+        if (i == nr_tests) {
+            fprintf(stderr, "allocbench: no test %s\n", argv[j]);
+            usage();
+        }
+        failed |= spawn(&tests[i]);
+    }
+    return failed ? 1 : 0;
+}
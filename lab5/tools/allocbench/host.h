@@ -0,0 +1,30 @@
+#ifndef __ALLOCBENCH_HOST_H__
+#define __ALLOCBENCH_HOST_H__
+
+/* *
+ * The interface between the two halves of allocbench. hostpmm.c is built
+ * like kernel code, against libs/, kern/mm/ and the replacement headers in
+ * include/; allocbench.c is an ordinary program using the C library. The
+ * two sets of headers define the same types differently, so only plain C
+ * types cross over here, and a struct Page * is an opaque handle.
+ * */
+
+#define HOST_NPAGE_MAX  16384           // pages in the arena, 64MB
+
+int host_pmm_count(void);
+const char *host_pmm_name(int idx);
+int host_pmm_select(int idx, unsigned long npage);
+void host_pmm_self_check(void);
+void host_pmm_track(int on);
+const char *host_pmm_verify(unsigned long *largest);
+
+void *host_alloc_pages(unsigned long n);
+void host_free_pages(void *page, unsigned long n);
+unsigned long host_nr_free_pages(void);
+void *host_page2kva(void *page);
+
+void *host_kmalloc(unsigned long size);
+void host_kfree(void *block);
+unsigned long host_ksize(const void *block);
+
+#endif /* !__ALLOCBENCH_HOST_H__ */
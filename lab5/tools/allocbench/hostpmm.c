@@ -0,0 +1,281 @@
+#include <defs.h>
+#include <list.h>
+#include <string.h>
+#include <pmm.h>
+#include <kmalloc.h>
+#include <default_pmm.h>
+#include <best_fit_pmm.h>
+#include <buddy_pmm.h>
+#include <slub.h>
+#include "host.h"
+
+/* *
+ * The kernel half of allocbench: what kern/mm/pmm.c is to the managers,
+ * over a static arena, plus consistency checks the fuzzer runs between
+ * operations.
+ * */
+
+struct host_pmm
+{
+    const struct pmm_manager *manager;
+    free_area_t *area;          // its address-ordered free list, NULL if it has none
+    bool pow2;                  // takes n pages from the next power of two up
+};
+
+// the managers of lab2, see lab2_*.c
+extern free_area_t *best_fit_free_area;
+
+static struct host_pmm host_pmms[] = {
+    {&default_pmm_manager, &free_area, 0},
+    {&best_fit_pmm_manager, NULL, 0},
+    {&buddy_pmm_manager, NULL, 1},
+    {&slub_pmm_manager, NULL, 0},
+};
+
+#define NR_HOST_PMMS (sizeof(host_pmms) / sizeof(host_pmms[0]))
+
+static struct Page host_pages[HOST_NPAGE_MAX];
+static char host_memory[HOST_NPAGE_MAX * PGSIZE] __attribute__((aligned(PGSIZE)));
+
+struct Page *pages;
+size_t npage;
+const size_t nbase = 0;
+char *host_arena = host_memory;
+const struct pmm_manager *pmm_manager;
+
+static struct host_pmm *host_cur;
+static bool host_tracking;
+static uint8_t host_allocated[HOST_NPAGE_MAX];  // handed out by alloc_pages, when tracking
+static size_t host_nr_allocated;                // taken from the manager, rounding included
+
+// host_taken - how many pages the manager takes for a request of @n
+static size_t
+host_taken(size_t n)
+{
+    size_t size = 1;
+    if (!host_cur->pow2)
+    {
+        return n;
+    }
+    while (size < n)
+    {
+        size <<= 1;
+    }
+    return size;
+}
+
+/* *
+ * alloc_pages - like the kernel's, minus the lock. While tracking, every
+ * page handed out is marked, so a page given out twice or freed without
+ * being allocated panics right at the call that did it.
+ * */
+struct Page *alloc_pages(size_t n)
+{
+    struct Page *page = pmm_manager->alloc_pages(n);
+    if (page != NULL && host_tracking)
+    {
+        assert(page >= pages && page + n <= pages + npage);
+        size_t i, idx = page - pages;
+        for (i = idx; i < idx + n; i++)
+        {
+            if (host_allocated[i])
+            {
+                panic("page %lu allocated twice", i);
+            }
+            host_allocated[i] = 1;
+        }
+        host_nr_allocated += host_taken(n);
+    }
+    return page;
+}
+
+void free_pages(struct Page *base, size_t n)
+{
+    if (host_tracking)
+    {
+        assert(base >= pages && base + n <= pages + npage);
+        size_t i, idx = base - pages;
+        for (i = idx; i < idx + n; i++)
+        {
+            if (!host_allocated[i])
+            {
+                panic("page %lu freed but not allocated", i);
+            }
+            host_allocated[i] = 0;
+        }
+        host_nr_allocated -= host_taken(n);
+    }
+    pmm_manager->free_pages(base, n);
+}
+
+size_t nr_free_pages(void)
+{
+    return pmm_manager->nr_free_pages();
+}
+
+int host_pmm_count(void)
+{
+    return NR_HOST_PMMS;
+}
+
+const char *host_pmm_name(int idx)
+{
+    return host_pmms[idx].manager->name;
+}
+
+/* *
+ * host_pmm_select - start manager @idx afresh over the first @npage pages
+ * of the arena, as page_init does over physical memory. Anything a
+ * previous manager handed out is forgotten, kmalloc's heap included.
+ * */
+int host_pmm_select(int idx, unsigned long nr)
+{
+    if (idx < 0 || idx >= (int)NR_HOST_PMMS || nr == 0 || nr > HOST_NPAGE_MAX)
+    {
+        return -1;
+    }
+    host_cur = &host_pmms[idx];
+    // not a constant for the table, see lab2_best_fit.c
+    if (host_cur->manager == &best_fit_pmm_manager)
+    {
+        host_cur->area = best_fit_free_area;
+    }
+    pmm_manager = host_cur->manager;
+    pages = host_pages, npage = nr;
+    memset(host_pages, 0, sizeof(host_pages));
+    memset(host_allocated, 0, sizeof(host_allocated));
+    host_nr_allocated = 0;
+
+    size_t i;
+    for (i = 0; i < npage; i++)
+    {
+        SetPageReserved(pages + i);
+    }
+    pmm_manager->init();
+    pmm_manager->init_memmap(pages, npage);
+    return 0;
+}
+
+// host_pmm_self_check - run the manager's own check(), as pmm_init does at boot
+void host_pmm_self_check(void)
+{
+    pmm_manager->check();
+}
+
+void host_pmm_track(int on)
+{
+    host_tracking = on;
+}
+
+/* *
+ * host_pmm_verify - check the manager's state against what has been handed
+ * out. Returns NULL if it is consistent, else what is wrong. @largest gets
+ * the size of the largest free block, 0 if the manager has no free list to
+ * walk. Pages are only accounted for while tracking is on.
+ * */
+const char *host_pmm_verify(unsigned long *largest)
+{
+    size_t nr_free = nr_free_pages();
+    *largest = 0;
+    if (host_tracking && host_nr_allocated + nr_free != npage)
+    {
+        return "allocated and free pages do not add up to npage";
+    }
+    if (host_cur->area == NULL)
+    {
+        return NULL;
+    }
+
+    list_entry_t *head = &(host_cur->area->free_list), *le = head;
+    struct Page *prev = NULL;
+    size_t total = 0;
+    while ((le = list_next(le)) != head)
+    {
+        struct Page *p = le2page(le, page_link), *q;
+        if (p < pages || p >= pages + npage)
+        {
+            return "free block outside the Page array";
+        }
+        if (list_next(list_prev(le)) != le)
+        {
+            return "free list links broken";
+        }
+        if (!PageProperty(p) || PageReserved(p))
+        {
+            return "free block head without PG_property or with PG_reserved";
+        }
+        if (p->property == 0 || p + p->property > pages + npage)
+        {
+            return "free block size out of range";
+        }
+        if (prev != NULL && prev + prev->property > p)
+        {
+            return "free blocks overlap or out of address order";
+        }
+        if (prev != NULL && prev + prev->property == p)
+        {
+            return "adjacent free blocks not merged";
+        }
+        for (q = p; q < p + p->property; q++)
+        {
+            if (host_tracking && host_allocated[q - pages])
+            {
+                return "allocated page on the free list";
+            }
+            if (q != p && PageProperty(q))
+            {
+                return "PG_property set inside a free block";
+            }
+            if (page_ref(q) != 0)
+            {
+                return "free page with a reference";
+            }
+        }
+        total += p->property;
+        if (p->property > *largest)
+        {
+            *largest = p->property;
+        }
+        prev = p;
+    }
+    if (total != nr_free || host_cur->area->nr_free != nr_free)
+    {
+        return "free list does not add up to nr_free";
+    }
+    return NULL;
+}
+
+void *host_alloc_pages(unsigned long n)
+{
+    return alloc_pages(n);
+}
+
+void host_free_pages(void *page, unsigned long n)
+{
+    free_pages(page, n);
+}
+
+unsigned long host_nr_free_pages(void)
+{
+    return nr_free_pages();
+}
+
+void *host_page2kva(void *page)
+{
+    return page2kva(page);
+}
+
+void *host_kmalloc(unsigned long size)
+{
+    return kmalloc(size);
+}
+
+void host_kfree(void *block)
+{
+    kfree(block);
+}
+
+unsigned long host_ksize(const void *block)
+{
+    return ksize(block);
+}
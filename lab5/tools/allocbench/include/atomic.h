@@ -0,0 +1,91 @@
+#ifndef __ALLOCBENCH_ATOMIC_H__
+#define __ALLOCBENCH_ATOMIC_H__
+
+/* *
+ * libs/atomic.h for the host: the same interface on top of the compiler's
+ * __atomic builtins instead of RISC-V AMOs.
+ * */
+
+#define BITS_PER_LONG 64
+
+#define BIT_MASK(nr) (1UL << ((nr) % BITS_PER_LONG))
+#define BIT_WORD(nr) ((nr) / BITS_PER_LONG)
+
+static inline void set_bit(int nr, volatile void *addr) {
+    __atomic_fetch_or((volatile unsigned long *)addr + BIT_WORD(nr), BIT_MASK(nr), __ATOMIC_SEQ_CST);
+}
+
+static inline void clear_bit(int nr, volatile void *addr) {
+    __atomic_fetch_and((volatile unsigned long *)addr + BIT_WORD(nr), ~BIT_MASK(nr), __ATOMIC_SEQ_CST);
+}
+
+static inline void change_bit(int nr, volatile void *addr) {
+    __atomic_fetch_xor((volatile unsigned long *)addr + BIT_WORD(nr), BIT_MASK(nr), __ATOMIC_SEQ_CST);
+}
+
+static inline bool test_bit(int nr, volatile void *addr) {
+    return (((*(volatile unsigned long *)addr) >> nr) & 1);
+}
+
+static inline bool test_and_set_bit(int nr, volatile void *addr) {
+    unsigned long old = __atomic_fetch_or((volatile unsigned long *)addr + BIT_WORD(nr), BIT_MASK(nr), __ATOMIC_SEQ_CST);
+    return (old & BIT_MASK(nr)) != 0;
+}
+
+static inline bool test_and_clear_bit(int nr, volatile void *addr) {
+    unsigned long old = __atomic_fetch_and((volatile unsigned long *)addr + BIT_WORD(nr), ~BIT_MASK(nr), __ATOMIC_SEQ_CST);
+    return (old & BIT_MASK(nr)) != 0;
+}
+
+typedef struct {
+    volatile int counter;
+} atomic_t;
+
+#define ATOMIC_INIT(i) { (i) }
+
+static inline int atomic_read(const atomic_t *v) {
+    return v->counter;
+}
+
+static inline void atomic_set(atomic_t *v, int i) {
+    v->counter = i;
+}
+
+static inline int atomic_fetch_add(atomic_t *v, int i) {
+    return __atomic_fetch_add(&v->counter, i, __ATOMIC_SEQ_CST);
+}
+
+static inline int atomic_add_return(atomic_t *v, int i) {
+    return atomic_fetch_add(v, i) + i;
+}
+
+static inline int atomic_sub_return(atomic_t *v, int i) {
+    return atomic_fetch_add(v, -i) - i;
+}
+
+static inline void atomic_add(atomic_t *v, int i) {
+    atomic_fetch_add(v, i);
+}
+
+static inline void atomic_inc(atomic_t *v) {
+    atomic_add(v, 1);
+}
+
+static inline void atomic_dec(atomic_t *v) {
+    atomic_add(v, -1);
+}
+
+static inline bool atomic_dec_and_test(atomic_t *v) {
+    return atomic_sub_return(v, 1) == 0;
+}
+
+static inline int atomic_xchg(atomic_t *v, int i) {
+    return __atomic_exchange_n(&v->counter, i, __ATOMIC_SEQ_CST);
+}
+
+static inline int atomic_cmpxchg(atomic_t *v, int old, int new) {
+    __atomic_compare_exchange_n(&v->counter, &old, new, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return old;
+}
+
+#endif /* !__ALLOCBENCH_ATOMIC_H__ */
@@ -0,0 +1,105 @@
+#ifndef __ALLOCBENCH_PMM_H__
+#define __ALLOCBENCH_PMM_H__
+
+#include <defs.h>
+#include <mmu.h>
+#include <memlayout.h>
+#include <atomic.h>
+#include <assert.h>
+
+/* *
+ * kern/mm/pmm.h for the host. The Page array describes the pages of a
+ * static arena instead of physical memory, so "physical" addresses are
+ * offsets into the arena (nbase is 0) and page2kva points into it.
+ * alloc_pages and friends go to the manager under test, see hostpmm.c.
+ * */
+struct pmm_manager
+{
+    const char *name;
+    void (*init)(void);
+    void (*init_memmap)(struct Page *base, size_t n);
+    struct Page *(*alloc_pages)(size_t n);
+    void (*free_pages)(struct Page *base, size_t n);
+    size_t (*nr_free_pages)(void);
+    void (*check)(void);
+};
+
+extern const struct pmm_manager *pmm_manager;
+extern const size_t nbase;
+
+struct Page *alloc_pages(size_t n);
+void free_pages(struct Page *base, size_t n);
+size_t nr_free_pages(void);
+
+#define alloc_page() alloc_pages(1)
+#define free_page(page) free_pages(page, 1)
+
+extern struct Page *pages;
+extern size_t npage;
+extern char *host_arena;
+
+static inline ppn_t
+page2ppn(struct Page *page)
+{
+    return page - pages + nbase;
+}
+
+static inline uintptr_t
+page2pa(struct Page *page)
+{
+    return page2ppn(page) << PGSHIFT;
+}
+
+static inline struct Page *
+pa2page(uintptr_t pa)
+{
+    if (PPN(pa) >= npage)
+    {
+        panic("pa2page called with invalid pa");
+    }
+    return &pages[PPN(pa) - nbase];
+}
+
+static inline void *
+page2kva(struct Page *page)
+{
+    return host_arena + page2pa(page);
+}
+
+static inline struct Page *
+kva2page(void *kva)
+{
+    if ((char *)kva < host_arena)
+    {
+        panic("kva2page called with invalid kva %p", kva);
+    }
+    return pa2page((char *)kva - host_arena);
+}
+
+static inline int
+page_ref(struct Page *page)
+{
+    return page->ref;
+}
+
+static inline void
+set_page_ref(struct Page *page, int val)
+{
+    page->ref = val;
+}
+
+static inline int
+page_ref_inc(struct Page *page)
+{
+    page->ref += 1;
+    return page->ref;
+}
+
+static inline int
+page_ref_dec(struct Page *page)
+{
+    page->ref -= 1;
+    return page->ref;
+}
+
+#endif /* !__ALLOCBENCH_PMM_H__ */
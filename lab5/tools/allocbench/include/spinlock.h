@@ -0,0 +1,71 @@
+#ifndef __ALLOCBENCH_SPINLOCK_H__
+#define __ALLOCBENCH_SPINLOCK_H__
+
+#include <defs.h>
+#include <sync.h>
+
+/* *
+ * kern/sync/spinlock.h for the host. allocbench drives the allocators
+ * from a single thread, so a lock only records that it is held, which
+ * still catches a lock taken twice or released unlocked.
+ * */
+typedef struct
+{
+    int locked;
+    const char *name;
+} spinlock_t;
+
+#define SPINLOCK_INIT(lockname) {.locked = 0, .name = (lockname)}
+
+static inline void
+spin_lock_init(spinlock_t *lock, const char *name)
+{
+    lock->locked = 0, lock->name = name;
+}
+
+static inline void
+spin_lock(spinlock_t *lock)
+{
+    assert(!lock->locked);
+    lock->locked = 1;
+}
+
+static inline bool
+spin_trylock(spinlock_t *lock)
+{
+    if (lock->locked)
+    {
+        return 0;
+    }
+    lock->locked = 1;
+    return 1;
+}
+
+static inline void
+spin_unlock(spinlock_t *lock)
+{
+    assert(lock->locked);
+    lock->locked = 0;
+}
+
+static inline bool
+spin_holding(spinlock_t *lock)
+{
+    return lock->locked;
+}
+
+#define spin_lock_irqsave(lock, x) \
+    do                             \
+    {                              \
+        local_intr_save(x);        \
+        spin_lock(lock);           \
+    } while (0)
+
+#define spin_unlock_irqrestore(lock, x) \
+    do                                  \
+    {                                   \
+        spin_unlock(lock);              \
+        local_intr_restore(x);          \
+    } while (0)
+
+#endif /* !__ALLOCBENCH_SPINLOCK_H__ */
@@ -0,0 +1,15 @@
+#ifndef __ALLOCBENCH_SYNC_H__
+#define __ALLOCBENCH_SYNC_H__
+
+#include <defs.h>
+#include <assert.h>
+
+// kern/sync/sync.h for the host: there are no interrupts to mask
+#define local_intr_save(x) \
+    do                     \
+    {                      \
+        x = 0;             \
+    } while (0)
+#define local_intr_restore(x) ((void)(x))
+
+#endif /* !__ALLOCBENCH_SYNC_H__ */
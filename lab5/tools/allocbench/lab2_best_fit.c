@@ -0,0 +1,8 @@
+/* *
+ * lab2's best_fit_pmm_manager, built over the arena. It is included rather
+ * than compiled on its own so that hostpmm.c can walk its free list, which
+ * best_fit_pmm.c keeps static.
+ * */
+#include "../../../lab2/kern/mm/best_fit_pmm.c"
+
+free_area_t *best_fit_free_area = &free_area;
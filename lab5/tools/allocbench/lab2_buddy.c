@@ -0,0 +1,2 @@
+// lab2's buddy_pmm_manager, built over the arena
+#include "../../../lab2/kern/mm/buddy_pmm.c"
@@ -0,0 +1,16 @@
+#include <defs.h>
+#include <stdio.h>
+
+/* *
+ * lab2's slub_pmm_manager, built over the arena. slub.c defines bool,
+ * page2kva and kva2page itself unless they are macros, and traces every
+ * call with cprintf: take the kernel's bool and the arena's pages instead,
+ * and keep the trace out of the BENCH output.
+ * */
+#define true 1
+#define false 0
+#define page2kva page2kva
+#define kva2page kva2page
+#define cprintf(...) ((void)0)
+
+#include "../../../lab2/kern/mm/slub.c"
@@ -0,0 +1,33 @@
+#!/bin/sh
+# benchcmp.sh NEW [OLD] - print the ns_per_op of every BENCH line in NEW,
+# and its change against the same benchmark in OLD (an earlier make bench).
+
+new="$1"
+old="$2"
+
+if [ -z "$new" ] || [ ! -f "$new" ]; then
+    echo "usage: $0 new.bench [old.bench]" >&2
+    exit 1
+fi
+
+awk -v oldfile="$old" '
+function field(key,    i) {
+    for (i = 3; i <= NF; i++) {
+        if (index($i, key "=") == 1) {
+            return substr($i, length(key) + 2)
+        }
+    }
+    return ""
+}
+{ sub(/\r$/, "") }
+$1 != "BENCH" || $2 == "timebase" { next }
+oldfile != "" && FILENAME == oldfile { base[$2] = field("ns_per_op"); next }
+{
+    ns = field("ns_per_op")
+    if (($2 in base) && base[$2] > 0) {
+        printf "%-20s %10d ns/op   was %10d ns/op   %+7.1f%%\n", $2, ns, base[$2], (ns - base[$2]) * 100 / base[$2]
+    } else {
+        printf "%-20s %10d ns/op\n", $2, ns
+    }
+}
+' $old "$new"
@@ -439,6 +439,47 @@ run_test -prog 'spin'  -check default_check
         'init check memory pass.'                               \
     ! - 'user panic at .*'
 
+run_test -prog 'futex'  -check default_check                                         \
+        'kernel_execve: pid = 2, name = "futex".'               \
+        'futex: 4 threads started.'                             \
+        'futex: counter is 80.'                                 \
+        'futex pass.'                                           \
+        'all user-mode processes have quit.'                    \
+        'init check memory pass.'                               \
+    ! - 'user panic at .*'
+
+run_test -prog 'sleep'  -check default_check                                         \
+        'kernel_execve: pid = 2, name = "sleep".'               \
+      - 'sleep 1 x 50 ms, elapsed [0-9]+ ms.'                   \
+      - 'sleep 5 x 50 ms, elapsed [0-9]+ ms.'                   \
+        'sleep pass.'                                           \
+        'all user-mode processes have quit.'                    \
+        'init check memory pass.'                               \
+    ! - 'user panic at .*'
+
+run_test -prog 'pipe'  -check default_check                                          \
+        'kernel_execve: pid = 2, name = "pipe".'                \
+        'pipe: read 65536 bytes.'                               \
+        'pipe pass.'                                            \
+        'all user-mode processes have quit.'                    \
+        'init check memory pass.'                               \
+    ! - 'user panic at .*'
+
+run_test -prog 'ipc'  -check default_check                                           \
+        'kernel_execve: pid = 2, name = "ipc".'                 \
+      - 'ipc: 2000 round trips in [0-9]+ ms.'                   \
+        'ipc pass.'                                             \
+        'all user-mode processes have quit.'                    \
+        'init check memory pass.'                               \
+    ! - 'user panic at .*'
+
+run_test -prog 'perf'  -check default_check                                          \
+        'kernel_execve: pid = 2, name = "perf".'                \
+        'perf pass.'                                            \
+        'all user-mode processes have quit.'                    \
+        'init check memory pass.'                               \
+    ! - 'user panic at .*'
+
 pts=15
 
 run_test -prog 'forktest'   -check default_check                                     \
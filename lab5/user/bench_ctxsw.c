@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include <ulib.h>
+#include <bench.h>
+
+#define ITERS 10000
+
+/* *
+ * Two processes yield to each other ITERS times each, so the loop makes
+ * 2 * ITERS context switches. Run with one hart (the default SMP=1), or
+ * the two may run side by side and not switch at all.
+ * */
+int
+main(void) {
+    struct bench b;
+    int i, pid, exit_code;
+
+    bench_init();
+
+    if ((pid = fork()) == 0) {
+        for (i = 0; i < ITERS; i ++) {
+            yield();
+        }
+        exit(0);
+    }
+    assert(pid > 0);
+
+    bench_start(&b, "yield_ctxsw");
+    for (i = 0; i < ITERS; i ++) {
+        yield();
+    }
+    bench_stop(&b, 2 * ITERS);
+    assert(waitpid(pid, &exit_code) == 0 && exit_code == 0);
+
+    cprintf("bench_ctxsw done.\n");
+    return 0;
+}
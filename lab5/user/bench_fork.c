@@ -0,0 +1,14 @@
+#include <stdio.h>
+#include <ulib.h>
+#include <bench.h>
+
+#define ITERS 500
+
+// no data of its own: bench_fork1 and up add dirty pages to this baseline
+int
+main(void) {
+    bench_init();
+    bench_fork_pages("fork_exit_wait", NULL, 0, ITERS);
+    cprintf("bench_fork done.\n");
+    return 0;
+}
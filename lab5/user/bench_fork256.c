@@ -0,0 +1,18 @@
+#include <stdio.h>
+#include <ulib.h>
+#include <riscv.h>
+#include <bench.h>
+
+#define PAGES 256
+#define ITERS 50
+
+// a separate program, so that fork copies exactly PAGES pages of data
+static char buf[PAGES * RISCV_PGSIZE] __attribute__((aligned(RISCV_PGSIZE)));
+
+int
+main(void) {
+    bench_init();
+    bench_fork_pages("fork_256pages", buf, PAGES, ITERS);
+    cprintf("bench_fork256 done.\n");
+    return 0;
+}
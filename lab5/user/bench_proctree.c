@@ -0,0 +1,44 @@
+#include <stdio.h>
+#include <ulib.h>
+#include <bench.h>
+
+#define DEPTH   64
+#define ROUNDS  10
+
+// chain - fork the next process of the chain and wait for it, DEPTH deep
+static void
+chain(int depth) {
+    int pid, exit_code;
+    if (depth == 0) {
+        exit(0);
+    }
+    if ((pid = fork()) == 0) {
+        chain(depth - 1);
+    }
+    if (pid < 0 || waitpid(pid, &exit_code) != 0 || exit_code != 0) {
+        exit(-1);
+    }
+    exit(0);
+}
+
+int
+main(void) {
+    struct bench b;
+    int i, pid, exit_code;
+
+    bench_init();
+
+    bench_start(&b, "proctree_depth64");
+    for (i = 0; i < ROUNDS; i ++) {
+        if ((pid = fork()) == 0) {
+            chain(DEPTH - 1);
+        }
+        assert(pid > 0);
+        assert(waitpid(pid, &exit_code) == 0 && exit_code == 0);
+    }
+    // per process in the chain
+    bench_stop(&b, ROUNDS * DEPTH);
+
+    cprintf("bench_proctree done.\n");
+    return 0;
+}
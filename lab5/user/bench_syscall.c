@@ -0,0 +1,30 @@
+#include <stdio.h>
+#include <ulib.h>
+#include <syscall.h>
+#include <bench.h>
+
+#define ITERS 100000
+
+int
+main(void) {
+    struct bench b;
+    int i;
+
+    bench_init();
+
+    // SYS_pgdir does nothing in the kernel: the bare trap round trip
+    bench_start(&b, "null_syscall");
+    for (i = 0; i < ITERS; i ++) {
+        sys_pgdir();
+    }
+    bench_stop(&b, ITERS);
+
+    bench_start(&b, "getpid");
+    for (i = 0; i < ITERS; i ++) {
+        getpid();
+    }
+    bench_stop(&b, ITERS);
+
+    cprintf("bench_syscall done.\n");
+    return 0;
+}
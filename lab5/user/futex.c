@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <ulib.h>
+#include <error.h>
+#include <unistd.h>
+#include <syscall.h>
+#include <thread.h>
+#include <mutex.h>
+
+#define NTHREADS    4
+#define LOOPS       20
+#define STACKSIZE   4096
+
+static char stacks[NTHREADS][STACKSIZE] __attribute__((aligned(16)));
+static mutex_t lock = MUTEX_INITIALIZER;
+static cond_t cond = COND_INITIALIZER;
+static volatile int counter, started, go;
+
+static int
+worker(void *arg) {
+    int i;
+    mutex_lock(&lock);
+    started ++;
+    while (!go) {
+        cond_wait(&cond, &lock);
+    }
+    mutex_unlock(&lock);
+
+    for (i = 0; i < LOOPS; i ++) {
+        mutex_lock(&lock);
+        int v = counter;
+        yield();                // let the others run into the held lock
+        counter = v + 1;
+        mutex_unlock(&lock);
+    }
+    return 0;
+}
+
+int
+main(void) {
+    volatile int word = 1;
+    assert(sys_futex(&word, FUTEX_WAIT, 0, 0, NULL) == -E_AGAIN);
+    assert(sys_futex(&word, FUTEX_WAKE, 1, 0, NULL) == 0);
+
+    assert(mutex_trylock(&lock) && !mutex_trylock(&lock));
+    mutex_unlock(&lock);
+
+    thread_t tids[NTHREADS];
+    int i, exit_code;
+    for (i = 0; i < NTHREADS; i ++) {
+        assert(thread(worker, NULL, stacks[i], STACKSIZE, &tids[i]) == 0);
+    }
+    // wait until every worker sleeps on the condvar, then release them all
+    while (started < NTHREADS) {
+        yield();
+    }
+    mutex_lock(&lock);
+    go = 1;
+    cond_broadcast(&cond);
+    mutex_unlock(&lock);
+    cprintf("futex: %d threads started.\n", NTHREADS);
+
+    for (i = 0; i < NTHREADS; i ++) {
+        assert(thread_wait(&tids[i], &exit_code) == 0 && exit_code == 0);
+    }
+    cprintf("futex: counter is %d.\n", counter);
+    assert(counter == NTHREADS * LOOPS);
+    cprintf("futex pass.\n");
+    return 0;
+}
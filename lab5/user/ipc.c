@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <ulib.h>
+#include <unistd.h>
+#include <error.h>
+
+#define ROUNDS  2000
+#define OP_ADD  1
+#define OP_QUIT 2
+
+static void
+server(void) {
+    uint64_t msg[IPC_MSG_WORDS];
+    int client = 0;
+    while (1) {
+        if ((client = ipc_reply_wait(client, msg)) < 0) {
+            panic("ipc: reply_wait failed %e.\n", client);
+        }
+        if (msg[0] == OP_QUIT) {
+            // exit without replying, the call fails
+            exit(0);
+        }
+        assert(msg[0] == OP_ADD);
+        msg[0] = 0, msg[1] = msg[1] + msg[2], msg[2] = ~msg[3];
+    }
+}
+
+int
+main(void) {
+    int pid, exit_code, i;
+    uint64_t msg[IPC_MSG_WORDS];
+
+    if ((pid = fork()) == 0) {
+        server();
+    }
+    assert(pid > 0);
+
+    unsigned int start = gettime_msec();
+    for (i = 0; i < ROUNDS; i ++) {
+        msg[0] = OP_ADD, msg[1] = i, msg[2] = 3 * i, msg[3] = i;
+        assert(ipc_call(pid, msg) == 0);
+        assert(msg[0] == 0 && msg[1] == 4 * i && msg[2] == ~(uint64_t)i);
+    }
+    cprintf("ipc: %d round trips in %d ms.\n", ROUNDS, gettime_msec() - start);
+
+    msg[0] = OP_QUIT;
+    assert(ipc_call(pid, msg) == -E_BAD_PROC);
+    assert(waitpid(pid, &exit_code) == 0 && exit_code == 0);
+    msg[0] = OP_ADD;
+    assert(ipc_call(pid, msg) == -E_BAD_PROC);
+    cprintf("ipc pass.\n");
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <defs.h>
+#include <riscv.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <ulib.h>
+#include <bench.h>
+
+#define BENCH_CALIBRATE_MS  100
+
+static uint64_t timebase_hz;
+static bool has_insns, has_cycles;
+
+/* *
+ * bench_init - find out how fast rdtime ticks: count them over
+ * BENCH_CALIBRATE_MS of gettime_msec, starting and ending on a clock tick,
+ * and open the instruction and cycle counters.
+ * */
+void
+bench_init(void) {
+    unsigned int ms0 = gettime_msec(), ms1, ms2;
+    uint64_t t1, t2;
+    while ((ms1 = gettime_msec()) == ms0) {
+        /* wait for a tick */ ;
+    }
+    t1 = rdtime();
+    while ((ms2 = gettime_msec()) - ms1 < BENCH_CALIBRATE_MS) {
+        /* spin */ ;
+    }
+    t2 = rdtime();
+    timebase_hz = (t2 - t1) * 1000 / (ms2 - ms1);
+    has_insns = (perf_open(PERF_INSTRUCTIONS) >= 0);
+    has_cycles = (perf_open(PERF_CYCLES) >= 0);
+    cprintf("BENCH timebase hz=%lu\n", timebase_hz);
+}
+
+void
+bench_start(struct bench *b, const char *name) {
+    b->name = name;
+    b->insns = b->cycles = 0;
+    if (has_insns) {
+        perf_read(PERF_INSTRUCTIONS, &(b->insns));
+    }
+    if (has_cycles) {
+        perf_read(PERF_CYCLES, &(b->cycles));
+    }
+    b->start = rdtime();
+}
+
+// bench_stop - print the result line of @b, which ran @iters operations
+void
+bench_stop(struct bench *b, int iters) {
+    uint64_t ticks = rdtime() - b->start, insns = 0, cycles = 0;
+    if (has_insns) {
+        perf_read(PERF_INSTRUCTIONS, &insns);
+        insns -= b->insns;
+    }
+    if (has_cycles) {
+        perf_read(PERF_CYCLES, &cycles);
+        cycles -= b->cycles;
+    }
+    uint64_t ns = (timebase_hz != 0) ? ticks * 1000000000 / timebase_hz : 0;
+    cprintf("BENCH %s iters=%d ticks=%lu ns_per_op=%lu", b->name, iters, ticks, ns / iters);
+    if (has_insns) {
+        cprintf(" insns_per_op=%lu", insns / iters);
+        if (has_cycles && cycles != 0) {
+            uint64_t ipc100 = insns * 100 / cycles;
+            cprintf(" ipc=%lu.%02lu", ipc100 / 100, ipc100 % 100);
+        }
+    }
+    cprintf("\n");
+}
+
+/* *
+ * bench_fork_pages - time fork + exit + wait with the first @pages pages of
+ * @buf dirtied (@buf may be NULL if @pages is 0). lab5 copies every mapped
+ * page at fork, so the size of the calling program's data matters as much
+ * as what it has written: give each size a program of its own.
+ * */
+void
+bench_fork_pages(const char *name, char *buf, int pages, int iters) {
+    struct bench b;
+    int i, pid, exit_code;
+    for (i = 0; i < pages; i ++) {
+        buf[i * RISCV_PGSIZE] = (char)i;
+    }
+    bench_start(&b, name);
+    for (i = 0; i < iters; i ++) {
+        if ((pid = fork()) == 0) {
+            exit(0);
+        }
+        assert(pid > 0);
+        assert(waitpid(pid, &exit_code) == 0 && exit_code == 0);
+    }
+    bench_stop(&b, iters);
+}
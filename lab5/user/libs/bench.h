@@ -0,0 +1,29 @@
+#ifndef __USER_LIBS_BENCH_H__
+#define __USER_LIBS_BENCH_H__
+
+#include <defs.h>
+
+/* *
+ * Microbenchmark helpers. A benchmark times a loop with rdtime and prints
+ * one line per measurement:
+ *
+ *   BENCH <name> iters=<n> ticks=<rdtime ticks> ns_per_op=<n> [insns_per_op=<n> ipc=<x.xx>]
+ *
+ * which tools/benchcmp.sh compares against a saved run (make bench). The
+ * timebase is calibrated against gettime_msec once, in bench_init; the
+ * instruction and cycle counts come from the PERF_* counters when the
+ * platform has them, and only cover the calling process.
+ * */
+
+struct bench {
+    const char *name;
+    uint64_t start;
+    uint64_t insns, cycles;
+};
+
+void bench_init(void);
+void bench_start(struct bench *b, const char *name);
+void bench_stop(struct bench *b, int iters);
+void bench_fork_pages(const char *name, char *buf, int pages, int iters);
+
+#endif /* !__USER_LIBS_BENCH_H__ */
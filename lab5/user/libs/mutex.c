@@ -0,0 +1,87 @@
+#include <defs.h>
+#include <unistd.h>
+#include <syscall.h>
+#include <mutex.h>
+
+/* The lock word protocol follows Drepper, "Futexes Are Tricky", mutex #2. */
+
+static inline int
+cmpxchg(volatile int *p, int old, int new) {
+    __atomic_compare_exchange_n(p, &old, new, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    return old;
+}
+
+static inline int
+xchg(volatile int *p, int new) {
+    return __atomic_exchange_n(p, new, __ATOMIC_ACQUIRE);
+}
+
+void
+mutex_init(mutex_t *m) {
+    m->val = 0;
+}
+
+void
+mutex_lock(mutex_t *m) {
+    int c;
+    if ((c = cmpxchg(&(m->val), 0, 1)) != 0) {
+        // contended: mark the lock as having waiters and sleep on it
+        if (c != 2) {
+            c = xchg(&(m->val), 2);
+        }
+        while (c != 0) {
+            sys_futex(&(m->val), FUTEX_WAIT, 2, 0, NULL);
+            c = xchg(&(m->val), 2);
+        }
+    }
+}
+
+bool
+mutex_trylock(mutex_t *m) {
+    return cmpxchg(&(m->val), 0, 1) == 0;
+}
+
+void
+mutex_unlock(mutex_t *m) {
+    if (__atomic_fetch_sub(&(m->val), 1, __ATOMIC_RELEASE) != 1) {
+        // there may be waiters, hand the lock back and wake one
+        __atomic_store_n(&(m->val), 0, __ATOMIC_RELEASE);
+        sys_futex(&(m->val), FUTEX_WAKE, 1, 0, NULL);
+    }
+}
+
+void
+cond_init(cond_t *c) {
+    c->seq = 0;
+    c->mutex = NULL;
+}
+
+void
+cond_wait(cond_t *c, mutex_t *m) {
+    int seq = c->seq;
+    c->mutex = m;
+    mutex_unlock(m);
+    sys_futex(&(c->seq), FUTEX_WAIT, seq, 0, NULL);
+    // we may have been requeued onto the mutex, so take it as contended
+    while (xchg(&(m->val), 2) != 0) {
+        sys_futex(&(m->val), FUTEX_WAIT, 2, 0, NULL);
+    }
+}
+
+void
+cond_signal(cond_t *c) {
+    __atomic_fetch_add(&(c->seq), 1, __ATOMIC_RELEASE);
+    sys_futex(&(c->seq), FUTEX_WAKE, 1, 0, NULL);
+}
+
+void
+cond_broadcast(cond_t *c) {
+    __atomic_fetch_add(&(c->seq), 1, __ATOMIC_RELEASE);
+    if (c->mutex == NULL) {
+        sys_futex(&(c->seq), FUTEX_WAKE, 0x7fffffff, 0, NULL);
+        return;
+    }
+    // wake one, and let the others queue on the mutex instead of
+    // all waking up just to fight over it
+    sys_futex(&(c->seq), FUTEX_REQUEUE, 1, 0x7fffffff, &(c->mutex->val));
+}
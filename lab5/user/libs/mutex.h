@@ -0,0 +1,33 @@
+#ifndef __USER_LIBS_MUTEX_H__
+#define __USER_LIBS_MUTEX_H__
+
+#include <defs.h>
+
+/* *
+ * Futex-based mutex and condition variable for threads sharing an address
+ * space. Taking a free mutex and releasing one nobody waits for never
+ * enters the kernel.
+ * */
+typedef struct {
+    volatile int val;       // 0: unlocked, 1: locked, 2: locked with waiters
+} mutex_t;
+
+typedef struct {
+    volatile int seq;       // bumped by every signal/broadcast
+    mutex_t *mutex;         // the mutex waiters use, for requeueing
+} cond_t;
+
+#define MUTEX_INITIALIZER   { 0 }
+#define COND_INITIALIZER    { 0, NULL }
+
+void mutex_init(mutex_t *m);
+void mutex_lock(mutex_t *m);
+bool mutex_trylock(mutex_t *m);
+void mutex_unlock(mutex_t *m);
+
+void cond_init(cond_t *c);
+void cond_wait(cond_t *c, mutex_t *m);
+void cond_signal(cond_t *c);
+void cond_broadcast(cond_t *c);
+
+#endif /* !__USER_LIBS_MUTEX_H__ */
@@ -1,15 +1,14 @@
 #include <defs.h>
 #include <stdio.h>
 #include <syscall.h>
+#include <string.h>
 
-/* *
- * cputch - writes a single character @c to stdout, and it will
- * increace the value of counter pointed by @cnt.
- * */
+#define CPRINTBUF_SIZE 128
+
+/* puts_sink - the printbuf sink of cprintf: one system call per buffer */
 static void
-cputch(int c, int *cnt) {
-    sys_putc(c);
-    (*cnt) ++;
+puts_sink(void *data, const char *s, size_t len) {
+    sys_puts(s, len);
 }
 
 /* *
@@ -23,9 +22,12 @@ cputch(int c, int *cnt) {
  * */
 int
 vcprintf(const char *fmt, va_list ap) {
-    int cnt = 0;
-    vprintfmt((void*)cputch, &cnt, fmt, ap);
-    return cnt;
+    char buf[CPRINTBUF_SIZE];
+    struct printbuf pb;
+    printbuf_init(&pb, buf, sizeof(buf), puts_sink, NULL);
+    vprintbuf(&pb, fmt, ap);
+    printbuf_flush(&pb);
+    return pb.cnt;
 }
 
 /* *
@@ -51,12 +53,8 @@ cprintf(const char *fmt, ...) {
  * */
 int
 cputs(const char *str) {
-    int cnt = 0;
-    char c;
-    while ((c = *str ++) != '\0') {
-        cputch(c, &cnt);
-    }
-    cputch('\n', &cnt);
-    return cnt;
+    size_t len = strlen(str);
+    sys_puts(str, len);
+    sys_puts("\n", 1);
+    return len + 1;
 }
-
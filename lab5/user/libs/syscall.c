@@ -51,6 +51,16 @@ sys_yield(void) {
     return syscall(SYS_yield);
 }
 
+int
+sys_sleep(uint64_t ms) {
+    return syscall(SYS_sleep, ms);
+}
+
+int
+sys_gettime(void) {
+    return syscall(SYS_gettime);
+}
+
 int
 sys_kill(int64_t pid) {
     return syscall(SYS_kill, pid);
@@ -66,8 +76,82 @@ sys_putc(int64_t c) {
     return syscall(SYS_putc, c);
 }
 
+int
+sys_puts(const char *buf, size_t len) {
+    return syscall(SYS_puts, buf, len);
+}
+
 int
 sys_pgdir(void) {
     return syscall(SYS_pgdir);
 }
 
+int
+sys_futex(volatile int *uaddr, int64_t op, int64_t val, int64_t val2, volatile int *uaddr2) {
+    return syscall(SYS_futex, uaddr, op, val, val2, uaddr2);
+}
+
+
+int
+sys_close(int64_t fd) {
+    return syscall(SYS_close, fd);
+}
+
+int
+sys_read(int64_t fd, void *base, size_t len) {
+    return syscall(SYS_read, fd, base, len);
+}
+
+int
+sys_write(int64_t fd, const void *base, size_t len) {
+    return syscall(SYS_write, fd, base, len);
+}
+
+int
+sys_pipe(int *fd_store) {
+    return syscall(SYS_pipe, fd_store);
+}
+
+/* *
+ * ipc_syscall - SYS_call and SYS_reply_wait pass the message in a2..a5 and
+ * get the answer back in a1..a4, which the generic syscall() cannot do.
+ * */
+static inline int
+ipc_syscall(int64_t num, int64_t pid, uint64_t *msg) {
+    register int64_t a0 asm("a0") = num;
+    register uint64_t a1 asm("a1") = pid;
+    register uint64_t a2 asm("a2") = msg[0];
+    register uint64_t a3 asm("a3") = msg[1];
+    register uint64_t a4 asm("a4") = msg[2];
+    register uint64_t a5 asm("a5") = msg[3];
+    asm volatile (
+        "ecall"
+        : "+r"(a0), "+r"(a1), "+r"(a2), "+r"(a3), "+r"(a4)
+        : "r"(a5)
+        : "memory");
+    int ret = (int)a0;
+    if (ret >= 0) {
+        msg[0] = a1, msg[1] = a2, msg[2] = a3, msg[3] = a4;
+    }
+    return ret;
+}
+
+int
+sys_call(int64_t pid, uint64_t *msg) {
+    return ipc_syscall(SYS_call, pid, msg);
+}
+
+int
+sys_reply_wait(int64_t pid, uint64_t *msg) {
+    return ipc_syscall(SYS_reply_wait, pid, msg);
+}
+
+int
+sys_perf_open(int64_t event) {
+    return syscall(SYS_perf_open, event);
+}
+
+int
+sys_perf_read(int64_t event, uint64_t *value_store) {
+    return syscall(SYS_perf_read, event, value_store);
+}
@@ -5,10 +5,22 @@ int sys_exit(int64_t error_code);
 int sys_fork(void);
 int sys_wait(int64_t pid, int *store);
 int sys_yield(void);
+int sys_sleep(uint64_t ms);
+int sys_gettime(void);
 int sys_kill(int64_t pid);
 int sys_getpid(void);
 int sys_putc(int64_t c);
+int sys_puts(const char *buf, size_t len);
 int sys_pgdir(void);
+int sys_close(int64_t fd);
+int sys_read(int64_t fd, void *base, size_t len);
+int sys_write(int64_t fd, const void *base, size_t len);
+int sys_pipe(int *fd_store);
+int sys_call(int64_t pid, uint64_t *msg);
+int sys_reply_wait(int64_t pid, uint64_t *msg);
+int sys_perf_open(int64_t event);
+int sys_perf_read(int64_t event, uint64_t *value_store);
+int sys_futex(volatile int *uaddr, int64_t op, int64_t val, int64_t val2, volatile int *uaddr2);
 
 #endif /* !__USER_LIBS_SYSCALL_H__ */
 
@@ -0,0 +1,37 @@
+#include <defs.h>
+#include <unistd.h>
+#include <error.h>
+#include <ulib.h>
+#include <thread.h>
+
+int __clone(uint32_t clone_flags, uintptr_t stack, int (*fn)(void *), void *arg);
+
+/* *
+ * thread - run fn(arg) in a new process sharing our address space, on the
+ * stack [stack, stack + stacksize) provided by the caller. The thread
+ * exits with fn's return value.
+ * */
+int
+thread(int (*fn)(void *), void *arg, void *stack, size_t stacksize, thread_t *tidp) {
+    if (fn == NULL || stack == NULL || tidp == NULL) {
+        return -E_INVAL;
+    }
+    // the stack grows down, keep sp 16-byte aligned
+    uintptr_t sp = ((uintptr_t)stack + stacksize) & ~(uintptr_t)15;
+    int ret = __clone(CLONE_VM | CLONE_FS, sp, fn, arg);
+    if (ret <= 0) {
+        return (ret == 0) ? -E_UNSPECIFIED : ret;
+    }
+    tidp->pid = ret;
+    return 0;
+}
+
+int
+thread_wait(thread_t *tidp, int *exit_code) {
+    return waitpid(tidp->pid, exit_code);
+}
+
+int
+thread_kill(thread_t *tidp) {
+    return kill(tidp->pid);
+}
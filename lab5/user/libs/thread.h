@@ -0,0 +1,14 @@
+#ifndef __USER_LIBS_THREAD_H__
+#define __USER_LIBS_THREAD_H__
+
+#include <defs.h>
+
+typedef struct {
+    int pid;
+} thread_t;
+
+int thread(int (*fn)(void *), void *arg, void *stack, size_t stacksize, thread_t *tidp);
+int thread_wait(thread_t *tidp, int *exit_code);
+int thread_kill(thread_t *tidp);
+
+#endif /* !__USER_LIBS_THREAD_H__ */
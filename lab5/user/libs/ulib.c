@@ -30,6 +30,16 @@ yield(void) {
     sys_yield();
 }
 
+void
+sleep(unsigned int ms) {
+    sys_sleep(ms);
+}
+
+unsigned int
+gettime_msec(void) {
+    return (unsigned int)sys_gettime();
+}
+
 int
 kill(int pid) {
     return sys_kill(pid);
@@ -46,3 +56,56 @@ print_pgdir(void) {
     sys_pgdir();
 }
 
+
+int
+pipe(int *fd_store) {
+    return sys_pipe(fd_store);
+}
+
+int
+read(int fd, void *base, size_t len) {
+    return sys_read(fd, base, len);
+}
+
+int
+write(int fd, const void *base, size_t len) {
+    return sys_write(fd, base, len);
+}
+
+int
+close(int fd) {
+    return sys_close(fd);
+}
+
+/* *
+ * ipc_call - send msg[0..IPC_MSG_WORDS-1] to process pid and wait for the
+ * reply, which overwrites msg.
+ * */
+int
+ipc_call(int pid, uint64_t *msg) {
+    return sys_call(pid, msg);
+}
+
+/* *
+ * ipc_reply_wait - reply msg to client pid (unless pid is 0), then wait for
+ * the next call; returns the caller's pid with its message in msg.
+ * */
+int
+ipc_reply_wait(int pid, uint64_t *msg) {
+    return sys_reply_wait(pid, msg);
+}
+
+/* *
+ * perf_open - count a PERF_* event for this process from now on; returns
+ * a handle for perf_read, or -E_NA_DEV if the hardware cannot count it.
+ * */
+int
+perf_open(int event) {
+    return sys_perf_open(event);
+}
+
+// perf_read - store what the event behind handle counted since perf_open
+int
+perf_read(int handle, uint64_t *value) {
+    return sys_perf_read(handle, value);
+}
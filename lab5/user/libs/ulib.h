@@ -28,9 +28,19 @@ int fork(void);
 int wait(void);
 int waitpid(int pid, int *store);
 void yield(void);
+void sleep(unsigned int ms);
+unsigned int gettime_msec(void);
 int kill(int pid);
 int getpid(void);
 void print_pgdir(void);
+int pipe(int *fd_store);
+int read(int fd, void *base, size_t len);
+int write(int fd, const void *base, size_t len);
+int close(int fd);
+int ipc_call(int pid, uint64_t *msg);
+int ipc_reply_wait(int pid, uint64_t *msg);
+int perf_open(int event);
+int perf_read(int handle, uint64_t *value);
 
 #endif /* !__USER_LIBS_ULIB_H__ */
 
@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <ulib.h>
+#include <unistd.h>
+#include <error.h>
+
+#define LOOPS 1000000
+
+static volatile uint64_t sink;
+
+static void
+work(void) {
+    int i;
+    for (i = 0; i < LOOPS; i ++) {
+        sink += i;
+    }
+}
+
+int
+main(void) {
+    uint64_t c0 = 0, c1 = 0, i0, i1, before, after;
+    int hc, hi;
+
+    assert(perf_open(PERF_NR_EVENTS) == -E_INVAL);
+    assert(perf_read(PERF_BRANCH_MISSES, &i0) == -E_INVAL);
+    if ((hi = perf_open(PERF_INSTRUCTIONS)) == -E_NA_DEV) {
+        cprintf("perf: no instruction counter, skipped.\n");
+        cprintf("perf pass.\n");
+        return 0;
+    }
+    assert(hi >= 0);
+    hc = perf_open(PERF_CYCLES);
+
+    assert(hc < 0 || perf_read(hc, &c0) == 0);
+    assert(perf_read(hi, &i0) == 0);
+    work();
+    assert(perf_read(hi, &i1) == 0);
+    assert(hc < 0 || perf_read(hc, &c1) == 0);
+    assert(i1 - i0 >= LOOPS);
+
+    // only the time we run is charged to us
+    assert(perf_read(hi, &before) == 0);
+    sleep(100);
+    assert(perf_read(hi, &after) == 0);
+    cprintf("perf: %d instructions in the loop, %d across sleep(100).\n", (int)(i1 - i0), (int)(after - before));
+    assert(after - before < i1 - i0);
+
+    if (c1 != c0) {
+        uint64_t ipc100 = (i1 - i0) * 100 / (c1 - c0);
+        cprintf("perf: ipc %d.%02d\n", (int)(ipc100 / 100), (int)(ipc100 % 100));
+    }
+    cprintf("perf pass.\n");
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <ulib.h>
+#include <error.h>
+
+#define TOTAL   (64 * 1024)
+#define WCHUNK  3000
+#define RCHUNK  1000
+
+static char wbuf[WCHUNK], rbuf[RCHUNK];
+
+static inline char
+pattern(int i) {
+    return (char)(i * 7 + 3);
+}
+
+static void
+producer(int fd) {
+    int sent = 0;
+    while (sent < TOTAL) {
+        int i, n = (TOTAL - sent < WCHUNK) ? TOTAL - sent : WCHUNK;
+        for (i = 0; i < n; i ++) {
+            wbuf[i] = pattern(sent + i);
+        }
+        assert(write(fd, wbuf, n) == n);
+        sent += n;
+    }
+    close(fd);
+    exit(0);
+}
+
+int
+main(void) {
+    int fd[2], pid, exit_code;
+
+    assert(pipe(fd) == 0);
+    if ((pid = fork()) == 0) {
+        close(fd[0]);
+        producer(fd[1]);
+    }
+    assert(pid > 0);
+    close(fd[1]);
+
+    int got = 0, ret;
+    while ((ret = read(fd[0], rbuf, RCHUNK)) > 0) {
+        int i;
+        for (i = 0; i < ret; i ++) {
+            if (rbuf[i] != pattern(got + i)) {
+                panic("pipe: bad byte at %d.\n", got + i);
+            }
+        }
+        got += ret;
+    }
+    assert(ret == 0);
+    cprintf("pipe: read %d bytes.\n", got);
+    assert(got == TOTAL);
+    assert(waitpid(pid, &exit_code) == 0 && exit_code == 0);
+    close(fd[0]);
+
+    assert(pipe(fd) == 0);
+    close(fd[0]);
+    assert(write(fd[1], wbuf, 1) == -E_PIPE);
+    close(fd[1]);
+    assert(read(fd[1], rbuf, 1) == -E_INVAL);
+
+    cprintf("pipe pass.\n");
+    return 0;
+}
@@ -0,0 +1,30 @@
+#include <stdio.h>
+#include <ulib.h>
+
+void
+sleepy(int pid) {
+    int i, time = 50;
+    for (i = 0; i < 5; i ++) {
+        unsigned int start = gettime_msec();
+        sleep(time);
+        unsigned int elapsed = gettime_msec() - start;
+        assert(elapsed >= time);
+        cprintf("sleep %d x %d ms, elapsed %d ms.\n", i + 1, time, elapsed);
+    }
+    exit(0);
+}
+
+int
+main(void) {
+    unsigned int time = gettime_msec();
+    int pid1, exit_code;
+
+    if ((pid1 = fork()) == 0) {
+        sleepy(pid1);
+    }
+
+    assert(waitpid(pid1, &exit_code) == 0 && exit_code == 0);
+    cprintf("use %04d msecs.\n", gettime_msec() - time);
+    cprintf("sleep pass.\n");
+    return 0;
+}